@@ -0,0 +1,83 @@
+#include "ConcurrentPathTable.h"
+#include "benchmark_utils.h"
+
+// Times the deletions and reinsertions of paths in the path tables, which maintain the makespan.
+// Every agent follows a shortest path that ignores the other agents. PathTableWC gets all paths,
+// while PathTable and ConcurrentPathTable get only the paths that do not collide with the earlier ones.
+// Each round deletes and reinserts the path of either the agent with the longest path (which used to make
+// the table rescan the goals of all locations) or a random agent.
+
+template <class T>
+static void deleteAndInsert(T& path_table, int agent, const Path& path)
+{
+    path_table.deletePath(agent, path);
+    path_table.insertPath(agent, path);
+}
+static void deleteAndInsert(PathTableWC& path_table, int agent, const Path&)
+{
+    path_table.deletePath(agent);
+    path_table.insertPath(agent);
+}
+
+template <class T>
+static void runRounds(const string& name, T& path_table, const vector<int>& agents, const vector<Path>& paths,
+                      int num_of_rounds)
+{
+    int longest_agent = agents.front();
+    for (int agent : agents)
+    {
+        if (paths[agent].size() > paths[longest_agent].size())
+            longest_agent = agent;
+    }
+    auto start = Time::now();
+    for (int i = 0; i < num_of_rounds; i++)
+        deleteAndInsert(path_table, longest_agent, paths[longest_agent]);
+    double longest_runtime = ((fsec)(Time::now() - start)).count();
+    start = Time::now();
+    for (int i = 0; i < num_of_rounds; i++)
+    {
+        int agent = agents[rand() % agents.size()];
+        deleteAndInsert(path_table, agent, paths[agent]);
+    }
+    double random_runtime = ((fsec)(Time::now() - start)).count();
+    cout << name << " (" << agents.size() << " paths, makespan " << paths[longest_agent].size() - 1 << "): "
+         << longest_runtime * 1e6 / num_of_rounds << " us per longest path, "
+         << random_runtime * 1e6 / num_of_rounds << " us per random path" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    po::options_description desc("Allowed options");
+    addInstanceOptions(desc, 1000);
+    desc.add_options()
+        ("rounds,q", po::value<int>()->default_value(100000), "number of deletions and reinsertions of each kind")
+        ;
+    po::variables_map vm;
+    if (!parseOptions(argc, argv, desc, vm))
+        return 1;
+
+    auto instance = loadInstance(vm);
+    int num_of_agents = instance->getDefaultNumberOfAgents();
+    auto paths = getShortestPaths(*instance);
+
+    PathTableWC path_table_wc(instance->map_size, num_of_agents);
+    PathTable path_table(instance->map_size);
+    ConcurrentPathTable concurrent_path_table(instance->map_size);
+    vector<int> all_agents, collision_free_agents;
+    for (int i = 0; i < num_of_agents; i++)
+    {
+        all_agents.push_back(i);
+        path_table_wc.insertPath(i, paths[i]);
+        if (path_table.hasCollisions(paths[i]))
+            continue;
+        collision_free_agents.push_back(i);
+        path_table.insertPath(i, paths[i]);
+        concurrent_path_table.insertPath(i, paths[i]);
+    }
+
+    int num_of_rounds = vm["rounds"].as<int>();
+    runRounds("PathTable", path_table, collision_free_agents, paths, num_of_rounds);
+    runRounds("PathTableWC", path_table_wc, all_agents, paths, num_of_rounds);
+    runRounds("ConcurrentPathTable", concurrent_path_table, collision_free_agents, paths, num_of_rounds);
+    return 0;
+}
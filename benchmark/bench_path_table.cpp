@@ -0,0 +1,77 @@
+#include <cfloat>
+#include "benchmark_utils.h"
+
+// Times the low-level searches (SIPP or space-time A*) against a path table.
+// The paths of all agents are planned once by prioritized planning and inserted into the table,
+// and then a random sequence of agents is replanned against the table, one at a time.
+// It reports the runtime per query and the throughput in expanded nodes per second.
+// To compare the layouts of the path table or the versions of the searches, run it on builds of the different
+// versions with the same seed (which replans the same agents and expands the same nodes),
+// e.g., under `perf stat -e cache-references,cache-misses`.
+// Do not compare path tables of different classes in one binary: the compiler speculatively devirtualizes
+// the cell accessors of PathTable, which favors PathTable over its derived classes.
+
+// return the runtime of the queries
+static double runQueries(vector<Agent>& agents, const Instance& instance, int num_of_queries, int seed,
+                         uint64_t& num_of_expanded)
+{
+    auto rss = getMemory("VmRSS");
+    PathTable path_table(instance.map_size);
+    for (const auto& agent : agents)
+        path_table.insertPath(agent.id, agent.path);
+    cout << "Path table: " << getMemory("VmRSS") - rss << " kB more resident memory" << endl;
+    srand(seed); // the same queries and tie breaking in every round
+    uint64_t num_of_generated = 0, sum_of_costs = 0, max_num_of_nodes = 0;
+    num_of_expanded = 0;
+    auto start = Time::now();
+    for (int i = 0; i < num_of_queries; i++)
+    {
+        auto& agent = agents[rand() % agents.size()];
+        path_table.deletePath(agent.id, agent.path);
+        ConstraintTable constraint_table(instance.num_of_cols, instance.map_size, &path_table);
+        auto path = agent.path_planner->findPath(constraint_table);
+        num_of_expanded += agent.path_planner->getNumExpanded();
+        num_of_generated += agent.path_planner->getNumGenerated();
+        max_num_of_nodes = max(max_num_of_nodes, agent.path_planner->getPeakNumOfNodes());
+        sum_of_costs += path.size() - 1;
+        path_table.insertPath(agent.id, agent.path); // keep the table unchanged
+    }
+    double runtime = ((fsec)(Time::now() - start)).count();
+    cout << num_of_queries << " queries in " << runtime << " seconds ("
+         << runtime * 1e6 / num_of_queries << " us/query, " << num_of_expanded / runtime / 1e6 << "M expansions/s), "
+         << num_of_expanded << " expanded and " << num_of_generated << " generated nodes, "
+         << "at most " << max_num_of_nodes << " nodes per query, sum of costs " << sum_of_costs << endl;
+    return runtime;
+}
+
+int main(int argc, char** argv)
+{
+    po::options_description desc("Allowed options");
+    addInstanceOptions(desc, 500);
+    desc.add_options()
+        ("sipp", po::value<bool>()->default_value(true), "Use SIPP (or space-time A*) as the low-level solver")
+        ("queries,q", po::value<int>()->default_value(10000), "number of calls to findPath per round")
+        ("rounds,r", po::value<int>()->default_value(3), "number of rounds (the fastest one is reported to reduce the noise of other processes)")
+        ;
+    po::variables_map vm;
+    if (!parseOptions(argc, argv, desc, vm))
+        return 1;
+
+    auto instance = loadInstance(vm);
+    vector<Agent> agents;
+    PathTable path_table(instance->map_size);
+    int num_of_failures = planByPP(*instance, vm["sipp"].as<bool>(), agents, path_table);
+    cout << instance->num_of_rows << "x" << instance->num_of_cols << " map, " << agents.size() << " agents ("
+         << num_of_failures << " without paths), makespan " << path_table.getMakespan() << ", "
+         << agents.front().path_planner->getName() << endl;
+
+    int seed = vm["seed"].as<int>();
+    int num_of_queries = vm["queries"].as<int>();
+    double best_time = DBL_MAX;
+    uint64_t num_of_expanded = 0; // the same in every round
+    for (int i = 0; i < vm["rounds"].as<int>(); i++)
+        best_time = min(best_time, runQueries(agents, *instance, num_of_queries, seed, num_of_expanded));
+    cout << "Fastest round: " << best_time * 1e6 / num_of_queries << " us/query, "
+         << num_of_expanded / best_time / 1e6 << "M expansions/s" << endl;
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <new>
+#include "benchmark_utils.h"
+
+// Measures the allocator calls, the memory and the runtime of PathTableWC.
+// Every agent follows a shortest path that ignores the other agents, so the paths collide as heavily as
+// the initial solutions of InitLNS. The benchmark inserts all paths and then repeatedly deletes and reinserts
+// the paths of random agents while counting their collisions, as the repairs of InitLNS do.
+
+static uint64_t num_of_allocations = 0;
+
+void* operator new(size_t size)
+{
+    num_of_allocations++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+int main(int argc, char** argv)
+{
+    po::options_description desc("Allowed options");
+    addInstanceOptions(desc, 5000);
+    desc.add_options()
+        ("repairs,q", po::value<int>()->default_value(100000), "number of deletions and reinsertions of paths")
+        ;
+    po::variables_map vm;
+    if (!parseOptions(argc, argv, desc, vm))
+        return 1;
+
+    auto instance = loadInstance(vm);
+    int num_of_agents = instance->getDefaultNumberOfAgents();
+    auto paths = getShortestPaths(*instance);
+
+    auto allocations = num_of_allocations;
+    auto rss = getMemory("VmRSS");
+    auto start = Time::now();
+    PathTableWC path_table(instance->map_size, num_of_agents);
+    for (int i = 0; i < num_of_agents; i++)
+        path_table.insertPath(i, paths[i]);
+    double runtime = ((fsec)(Time::now() - start)).count();
+    cout << "Insert " << num_of_agents << " paths: " << runtime << " seconds, "
+         << num_of_allocations - allocations << " allocations, "
+         << getMemory("VmRSS") - rss << " kB more resident memory" << endl;
+
+    int num_of_repairs = vm["repairs"].as<int>();
+    uint64_t num_of_collisions = 0;
+    allocations = num_of_allocations;
+    start = Time::now();
+    for (int i = 0; i < num_of_repairs; i++)
+    {
+        int agent = rand() % num_of_agents;
+        path_table.deletePath(agent);
+        const auto& path = paths[agent];
+        for (int t = 1; t < (int) path.size(); t++)
+            num_of_collisions += path_table.getNumOfCollisions(path[t - 1].location, path[t].location, t);
+        path_table.insertPath(agent);
+    }
+    runtime = ((fsec)(Time::now() - start)).count();
+    cout << num_of_repairs << " repairs: " << runtime << " seconds, "
+         << num_of_allocations - allocations << " allocations, " << num_of_collisions << " collisions" << endl;
+    cout << "Peak resident memory: " << getMemory("VmHWM") << " kB" << endl;
+    return 0;
+}
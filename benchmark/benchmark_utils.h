@@ -0,0 +1,124 @@
+#pragma once
+#include <queue>
+#include <memory>
+#include <boost/program_options.hpp>
+#include "BasicLNS.h"
+
+// The helpers shared by the benchmarks
+
+namespace po = boost::program_options;
+
+// add the options of the instance and the random seed, which all benchmarks share
+inline void addInstanceOptions(po::options_description& desc, int default_num_of_agents)
+{
+    desc.add_options()
+        ("help", "produce help message")
+        ("map,m", po::value<string>()->required(), "input file for map")
+        ("agents,a", po::value<string>()->required(), "input file for agents")
+        ("agentNum,k", po::value<int>()->default_value(default_num_of_agents), "number of agents")
+        ("rows", po::value<int>()->default_value(256), "number of rows of the generated map")
+        ("cols", po::value<int>()->default_value(256), "number of columns of the generated map")
+        ("obstacles", po::value<int>()->default_value(256 * 256 / 10), "number of obstacles of the generated map")
+        ("seed", po::value<int>()->default_value(0), "Random seed")
+        ;
+}
+
+// return false if the help message is printed instead
+inline bool parseOptions(int argc, char** argv, const po::options_description& desc, po::variables_map& vm)
+{
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+        cout << desc << endl;
+        return false;
+    }
+    po::notify(vm);
+    return true;
+}
+
+// seed rand() and load the instance.
+// If the map file does not exist, a random map of the given size and random agents are generated
+// (the generated map is not in the format of the MovingAI benchmark, so it can be reused only with the generated agents).
+inline std::unique_ptr<Instance> loadInstance(const po::variables_map& vm)
+{
+    srand(vm["seed"].as<int>());
+    return std::unique_ptr<Instance>(new Instance(vm["map"].as<string>(), vm["agents"].as<string>(),
+            vm["agentNum"].as<int>(), vm["rows"].as<int>(), vm["cols"].as<int>(), vm["obstacles"].as<int>()));
+}
+
+// create the agents and plan their paths by prioritized planning, where the agents without paths keep empty paths
+// and stay out of path_table. Return the number of agents without paths.
+inline int planByPP(const Instance& instance, bool sipp, vector<Agent>& agents, PathTable& path_table)
+{
+    agents.reserve(instance.getDefaultNumberOfAgents());
+    for (int i = 0; i < instance.getDefaultNumberOfAgents(); i++)
+        agents.emplace_back(instance, i, sipp);
+    int num_of_failures = 0;
+    for (auto& agent : agents)
+    {
+        ConstraintTable constraint_table(instance.num_of_cols, instance.map_size, &path_table);
+        agent.path = agent.path_planner->findPath(constraint_table);
+        if (agent.path.empty())
+            num_of_failures++;
+        path_table.insertPath(agent.id, agent.path);
+    }
+    return num_of_failures;
+}
+
+// return the resident set size in kB (field is VmRSS or VmHWM)
+inline long getMemory(const string& field)
+{
+    std::ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+    {
+        if (line.compare(0, field.size() + 1, field + ":") == 0)
+            return atol(line.c_str() + field.size() + 1);
+    }
+    return -1;
+}
+
+// return a shortest path from start to goal that ignores the other agents (exit if there is none)
+inline Path getShortestPath(const Instance& instance, int start, int goal, vector<int>& parents)
+{
+    std::fill(parents.begin(), parents.end(), -1);
+    std::queue<int> open;
+    open.push(start);
+    parents[start] = start;
+    while (!open.empty() and parents[goal] < 0)
+    {
+        int curr = open.front();
+        open.pop();
+        for (int next : instance.getNeighbors(curr))
+        {
+            if (parents[next] < 0)
+            {
+                parents[next] = curr;
+                open.push(next);
+            }
+        }
+    }
+    if (parents[goal] < 0)
+    {
+        cerr << "Goal location " << goal << " is unreachable from start location " << start << endl;
+        exit(-1);
+    }
+    Path path;
+    for (int curr = goal; curr != start; curr = parents[curr])
+        path.emplace_back(curr);
+    path.emplace_back(start);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// return the shortest paths of all agents, which ignore the other agents and so may collide with each other
+inline vector<Path> getShortestPaths(const Instance& instance)
+{
+    int num_of_agents = instance.getDefaultNumberOfAgents();
+    vector<Path> paths(num_of_agents);
+    vector<int> parents(instance.map_size);
+    auto starts = instance.getStarts();
+    auto goals = instance.getGoals();
+    for (int i = 0; i < num_of_agents; i++)
+        paths[i] = getShortestPath(instance, starts[i], goals[i], parents);
+    return paths;
+}
@@ -31,7 +31,15 @@ struct Neighbor
     int old_sum_of_costs;
     set<pair<int, int>> colliding_pairs;  // id1 < id2
     set<pair<int, int>> old_colliding_pairs;  // id1 < id2
+    // the paths of the agents before the repair, where old_paths[i] belongs to agents[i].
+    // It never shrinks, so the paths keep their memory across iterations, and a rejected repair is rolled back
+    // by swapping the old paths back without allocating any memory.
     vector<Path> old_paths;
+    void resizeOldPaths()
+    {
+        if (old_paths.size() < agents.size())
+            old_paths.resize(agents.size());
+    }
 };
 
 class BasicLNS
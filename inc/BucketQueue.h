@@ -0,0 +1,208 @@
+#pragma once
+#include <cassert>
+#include <random>
+#include "common.h"
+
+// The position of a node in a BucketQueue
+struct BucketQueueHandle
+{
+    int primary_key = 0;
+    int secondary_key = 0;
+    int index = 0; // in the heap of the bucket
+    unsigned tie_breaker = 0;
+};
+
+// A priority queue for the nodes of low-level searches, whose keys are small integers (e.g., f-vals and numbers of conflicts).
+// The nodes with the same primary and secondary keys share a bucket, and the buckets are indexed directly by the two keys,
+// so a push or a pop costs O(1) plus a heap operation inside a bucket, where the nodes are ordered by the tertiary key and
+// then by a random number drawn when they are pushed. Ties are thus broken randomly but in the same way in every run.
+// Priority provides static functions primary, secondary and tertiary of a node. Smaller keys come first.
+// handle is the member of Node that stores the position of the node in this queue.
+// clear() empties the buckets but keeps their memory (up to MAX_KEPT_ITEMS levels and buckets per level),
+// so a queue can be shared by the searches of a thread. The keys of an empty queue or level start a new range,
+// so the searches do not add up their ranges of keys.
+// The random numbers come from a generator that the owner of the search sets by setRandomGenerator().
+template<class Node, class Priority, BucketQueueHandle Node::* handle>
+class BucketQueue
+{
+public:
+    bool empty() const { return num_of_nodes == 0; }
+    size_t size() const { return num_of_nodes; }
+    void setRandomGenerator(std::minstd_rand& generator) { random_generator = &generator; }
+
+    void push(Node* node)
+    {
+        (node->*handle).tie_breaker = (unsigned) (*random_generator)();
+        insert(node);
+    }
+    Node* top() const
+    {
+        assert(!empty());
+        const auto& level = levels[min_primary_key - base];
+        return level.buckets[level.min_secondary_key - level.base].front();
+    }
+    void pop() { erase(top()); }
+    void erase(Node* node)
+    {
+        const auto& position = node->*handle;
+        int primary_key = position.primary_key;
+        int secondary_key = position.secondary_key;
+        auto& level = levels[primary_key - base];
+        auto& bucket = level.buckets[secondary_key - level.base];
+        int index = position.index;
+        assert(bucket[index] == node);
+        Node* last = bucket.back();
+        bucket.pop_back();
+        if (last != node)
+        {
+            place(bucket, index, last);
+            if (index > 0 and less(last, bucket[(index - 1) / 2]))
+                siftUp(bucket, index);
+            else
+                siftDown(bucket, index);
+        }
+        num_of_nodes--;
+        level.num_of_nodes--;
+        if (bucket.empty() and secondary_key == level.min_secondary_key and level.num_of_nodes > 0)
+        {
+            while (level.buckets[level.min_secondary_key - level.base].empty())
+                level.min_secondary_key++;
+        }
+        if (level.num_of_nodes == 0 and primary_key == min_primary_key and num_of_nodes > 0)
+        {
+            while (levels[min_primary_key - base].num_of_nodes == 0)
+                min_primary_key++;
+        }
+    }
+    void update(Node* node) // move the node after its keys have changed; it keeps its tie breaker
+    {
+        erase(node);
+        insert(node);
+    }
+    void clear() // remove all nodes
+    {
+        if (levels.size() > MAX_KEPT_ITEMS) // only after an unusually wide range of keys
+        {
+            vector<Level>().swap(levels);
+            num_of_nodes = 0;
+            return;
+        }
+        for (auto& level : levels)
+        {
+            if (level.buckets.size() > MAX_KEPT_ITEMS)
+                vector<Bucket>().swap(level.buckets);
+            else if (level.num_of_nodes > 0)
+            {
+                for (auto& bucket : level.buckets)
+                    bucket.clear();
+            }
+            num_of_nodes -= level.num_of_nodes;
+            level.num_of_nodes = 0;
+        }
+        assert(num_of_nodes == 0);
+    }
+
+    // call func on every node whose primary key is in [min_key, max_key]
+    template<class Func>
+    void forEach(int min_key, int max_key, Func func) const
+    {
+        for (int key = max(min_key, base); key <= max_key and key - base < (int)levels.size(); key++)
+        {
+            for (const auto& bucket : levels[key - base].buckets)
+            {
+                for (auto node : bucket)
+                    func(node);
+            }
+        }
+    }
+
+private:
+    static const size_t MAX_KEPT_ITEMS = 4096;
+    typedef vector<Node*> Bucket; // a binary heap
+    struct Level // the buckets of the same primary key
+    {
+        int base = 0; // the secondary key of buckets[0]
+        int min_secondary_key = 0; // of the nonempty buckets
+        int num_of_nodes = 0;
+        vector<Bucket> buckets;
+    };
+    int base = 0; // the primary key of levels[0]
+    int min_primary_key = 0; // of the nonempty levels
+    size_t num_of_nodes = 0;
+    vector<Level> levels;
+    std::minstd_rand* random_generator = nullptr;
+
+    // return the item of the given key, adding items in front of or behind the others if needed.
+    // If all items are empty, they are reused for the range of keys that starts at the key.
+    template<class T>
+    static T& getItem(vector<T>& items, int& items_base, int key, bool all_empty)
+    {
+        if (items.empty() or all_empty)
+            items_base = key;
+        else if (key < items_base)
+        {
+            items.insert(items.begin(), items_base - key, T());
+            items_base = key;
+        }
+        if (key - items_base >= (int)items.size())
+            items.resize(key - items_base + 1);
+        return items[key - items_base];
+    }
+
+    void insert(Node* node)
+    {
+        auto& position = node->*handle;
+        position.primary_key = Priority::primary(node);
+        position.secondary_key = Priority::secondary(node);
+        auto& level = getItem(levels, base, position.primary_key, num_of_nodes == 0);
+        auto& bucket = getItem(level.buckets, level.base, position.secondary_key, level.num_of_nodes == 0);
+        if (num_of_nodes == 0 or position.primary_key < min_primary_key)
+            min_primary_key = position.primary_key;
+        if (level.num_of_nodes == 0 or position.secondary_key < level.min_secondary_key)
+            level.min_secondary_key = position.secondary_key;
+        num_of_nodes++;
+        level.num_of_nodes++;
+        bucket.push_back(node);
+        position.index = (int)bucket.size() - 1;
+        siftUp(bucket, position.index);
+    }
+
+    static bool less(const Node* n1, const Node* n2)
+    {
+        int k1 = Priority::tertiary(n1), k2 = Priority::tertiary(n2);
+        if (k1 == k2)
+            return (n1->*handle).tie_breaker < (n2->*handle).tie_breaker;
+        return k1 < k2;
+    }
+    static void place(Bucket& bucket, int index, Node* node)
+    {
+        bucket[index] = node;
+        (node->*handle).index = index;
+    }
+    static void siftUp(Bucket& bucket, int index)
+    {
+        Node* node = bucket[index];
+        while (index > 0 and less(node, bucket[(index - 1) / 2]))
+        {
+            place(bucket, index, bucket[(index - 1) / 2]);
+            index = (index - 1) / 2;
+        }
+        place(bucket, index, node);
+    }
+    static void siftDown(Bucket& bucket, int index)
+    {
+        Node* node = bucket[index];
+        int size = (int)bucket.size();
+        while (2 * index + 1 < size)
+        {
+            int child = 2 * index + 1;
+            if (child + 1 < size and less(bucket[child + 1], bucket[child]))
+                child++;
+            if (!less(bucket[child], node))
+                break;
+            place(bucket, index, bucket[child]);
+            index = child;
+        }
+        place(bucket, index, node);
+    }
+};
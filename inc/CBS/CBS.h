@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include "CBSHeuristic.h"
 #include "RectangleReasoning.h"
 #include "CorridorReasoning.h"
@@ -68,6 +69,9 @@ public:
 		suboptimality = w;
 	}
 	void setNodeLimit(int n) { node_limit = n; }
+	void setStopFlag(const std::atomic<bool>* flag) { stop_flag = flag; } // another thread can stop the search
+	// the search also stops at the deadline in wall time, while its time limit is in CPU time of the whole process
+	void setDeadline(const Time::time_point& time) { deadline = time; }
 
 	////////////////////////////////////////////////////////////////////////////////////////////
 	// Runs the algorithm until the problem is solved or time is exhausted 
@@ -124,11 +128,53 @@ protected:
 	int cost_lowerbound = 0;
 	int inadmissible_cost_lowerbound;
 	int node_limit = MAX_NODES;
+	const std::atomic<bool>* stop_flag = nullptr;
+	Time::time_point deadline = Time::time_point::max();
+	bool stopped() const { return (stop_flag != nullptr && *stop_flag) || Time::now() > deadline; }
 	int cost_upperbound = MAX_COST;
 
 	vector<ConstraintTable> initial_constraints;
 	clock_t start;
 
+	// the conflict avoidance table of the low-level searches, i.e., the paths of all agents but the one being replanned.
+	// Instead of being rebuilt for every low-level search, it is patched with the paths that have changed since the last one.
+	// Every change of paths therefore has to go through setPath/setPaths or be reported by markChangedInCAT,
+	// including the bypasses that rewrite paths in place and the deletions of CT nodes whose paths may be in paths.
+	PathTableWC path_table_for_CAT;
+	vector<bool> paths_in_CAT; // whether path_table_for_CAT contains the path of the agent
+	vector<Path> copies_in_CAT; // copies of these paths, as the CT nodes that own them can be deleted in the meantime
+	vector<int> agents_changed_in_CAT; // the agents whose paths have changed since the last patch
+	vector<bool> changed_in_CAT; // whether the agent is in agents_changed_in_CAT
+	int agent_out_of_CAT = -1; // the agent of the last low-level search, whose path is not in path_table_for_CAT
+	void updateCAT(int agent); // patch path_table_for_CAT with paths and let the low-level search of agent use it
+	void markChangedInCAT(int agent)
+	{
+		if (!changed_in_CAT.empty() and !changed_in_CAT[agent]) // nothing to do before the CAT is built
+		{
+			changed_in_CAT[agent] = true;
+			agents_changed_in_CAT.push_back(agent);
+		}
+	}
+	template<class Node>
+	void markChangedInCAT(const Node& node) // the paths of the node are deleted or rewritten
+	{
+		for (const auto& path : node.paths)
+			markChangedInCAT(path.first);
+	}
+	void setPath(int agent, Path* path)
+	{
+		if (paths[agent] != path)
+		{
+			paths[agent] = path;
+			markChangedInCAT(agent);
+		}
+	}
+	void setPaths(const vector<Path*>& new_paths)
+	{
+		for (int i = 0; i < num_of_agents; i++)
+			setPath(i, new_paths[i]);
+	}
+
 	int num_of_agents;
 
 
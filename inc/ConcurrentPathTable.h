@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include "PathTable.h"
+
+// A path table that can be read by many threads while another thread inserts or deletes paths.
+// Reads are wait-free, and insertions and deletions update the cells by compare-and-swap.
+// The cells of a location are stored in buckets of geometrically increasing sizes,
+// so a row can grow without moving the cells that other threads are reading.
+class ConcurrentPathTable final : public ReadOnlyPathTable
+{
+public:
+    explicit ConcurrentPathTable(int map_size = 0);
+    ConcurrentPathTable(const ConcurrentPathTable&) = delete;
+    ConcurrentPathTable& operator=(const ConcurrentPathTable&) = delete;
+    ~ConcurrentPathTable() override;
+
+    // Insertions and deletions must not run concurrently with each other,
+    // but can run concurrently with any of the read functions below.
+    void reset();
+    void insertPath(int agent_id, const Path& path);
+    void deletePath(int agent_id, const Path& path);
+
+    bool constrained(int from, int to, int to_time) const override;
+    int getHoldingTime(int location, int earliest_timestep) const override;
+    bool empty() const override { return map_size == 0; }
+    int getMakespan() const override { return concurrent_makespan.load(std::memory_order_acquire); }
+    int getLength(int location) const override { return lengths[location].load(std::memory_order_acquire); }
+    int getAgent(int location, int timestep) const override
+    {
+        if (timestep >= getLength(location))
+            return NO_AGENT;
+        int bucket, offset;
+        getBucket(timestep, bucket, offset);
+        if (bucket >= NUM_BUCKETS) // e.g., a negative timestep
+            return NO_AGENT;
+        const auto* cells = buckets[location * NUM_BUCKETS + bucket].load(std::memory_order_acquire);
+        return cells == nullptr ? NO_AGENT : cells[offset].load(std::memory_order_acquire);
+    }
+    int getGoalTime(int location) const override { return goal_times[location].load(std::memory_order_acquire); }
+    void getIntervals(int location, vector<AgentInterval>& intervals) const override
+    {
+        getIntervalsByCells(*this, location, intervals);
+    }
+    const vector<Interval>* getSafeIntervals(int) const override { return nullptr; }
+
+private:
+    static const int FIRST_BUCKET_SIZE = 16; // bucket b stores FIRST_BUCKET_SIZE * 2^b timesteps
+    static const int NUM_BUCKETS = 24;
+    int map_size;
+    std::atomic<std::atomic<int>*>* buckets; // map_size x NUM_BUCKETS
+    std::atomic<int>* lengths;
+    std::atomic<int>* goal_times;
+    std::atomic<int> concurrent_makespan;
+    GoalTimeCounter goal_time_counter; // only accessed by the thread that inserts and deletes paths
+
+    static inline void getBucket(int timestep, int& bucket, int& offset)
+    {
+        unsigned x = (unsigned) timestep / FIRST_BUCKET_SIZE + 1;
+        bucket = 31 - __builtin_clz(x);
+        offset = timestep - FIRST_BUCKET_SIZE * ((1 << bucket) - 1);
+    }
+    std::atomic<int>& getCell(int location, int timestep); // allocate the bucket if necessary
+    void clearBuckets();
+};
+
+// A read-only view of a path table that ignores the paths of the given agents,
+// e.g., the agents that the caller is replanning.
+class PathTableView final : public ReadOnlyPathTable
+{
+public:
+    PathTableView(const ReadOnlyPathTable& path_table, const vector<bool>& ignored) : path_table(path_table), ignored(ignored) {}
+
+    bool constrained(int from, int to, int to_time) const override;
+    int getHoldingTime(int location, int earliest_timestep) const override;
+    bool empty() const override { return path_table.empty(); }
+    int getMakespan() const override { return path_table.getMakespan(); }
+    int getLength(int location) const override { return path_table.getLength(location); }
+    int getAgent(int location, int timestep) const override
+    {
+        int agent = path_table.getAgent(location, timestep);
+        return (agent == NO_AGENT or ignored[agent]) ? NO_AGENT : agent;
+    }
+    int getGoalTime(int location) const override;
+    void getIntervals(int location, vector<AgentInterval>& intervals) const override
+    {
+        getIntervalsByCells(*this, location, intervals);
+    }
+    const vector<Interval>* getSafeIntervals(int) const override { return nullptr; }
+
+private:
+    const ReadOnlyPathTable& path_table;
+    const vector<bool>& ignored;
+};
@@ -10,8 +10,8 @@ public:
 	int length_max = MAX_TIMESTEP;
 	size_t num_col;
 	size_t map_size;
-    const PathTable * path_table_for_CT;
-    const PathTableWC * path_table_for_CAT;
+    const ReadOnlyPathTable * path_table_for_CT;
+    const ReadOnlyPathTableWC * path_table_for_CAT;
 
 	int getHoldingTime(int location, int earliest_timestep) const; // the earliest timestep that the agent can hold the location after earliest_timestep
     int getMaxTimestep() const; // everything is static after the max timestep
@@ -25,8 +25,8 @@ public:
     bool hasEdgeConflict(size_t curr_id, size_t next_id, int next_timestep) const;
     int getFutureNumOfCollisions(int loc, int t) const;
 
-	ConstraintTable(size_t num_col, size_t map_size, const PathTable* path_table_for_CT = nullptr,
-	        const PathTableWC * path_table_for_CAT = nullptr) :
+	ConstraintTable(size_t num_col, size_t map_size, const ReadOnlyPathTable* path_table_for_CT = nullptr,
+	        const ReadOnlyPathTableWC * path_table_for_CAT = nullptr) :
             num_col(num_col), map_size(map_size), path_table_for_CT(path_table_for_CT),
             path_table_for_CAT(path_table_for_CAT) {}
 	ConstraintTable(const ConstraintTable& other) { copy(other); }
@@ -36,7 +36,8 @@ public:
 	void init(const ConstraintTable& other) { copy(other); }
 	void clear()
 	{
-	    ct.clear();
+	    ct.reset();
+	    ct_num_of_sorted = 0;
 	    landmarks.clear();
 	    cat.clear();
 	}
@@ -51,17 +52,39 @@ public:
 
 protected:
     friend class ReservationTable;
-    typedef unordered_map<size_t, list< pair<int, int> > > CT; // constraint table
-	CT ct; // location -> time range, or edge -> time range
+    struct CTEntry
+    {
+        size_t location; // or edge index
+        int t_min;
+        int t_max; // the location is constrained in [t_min, t_max)
+    };
+    // the constraint table is a flat array sorted by location (with the edges after the vertices, as their indices are larger)
+    // and then by the order of insertion, which is searched by binary search instead of hashing.
+    // New constraints are appended and merged into the sorted ones at the next query, so that inserting
+    // many constraints (e.g., whole paths) does not shift the array every time.
+    // Copies of the table share the (sorted) array until one of them inserts a constraint.
+    typedef vector<CTEntry> CT;
+	shared_ptr<CT> ct; // nullptr if there are no constraints
+	mutable size_t ct_num_of_sorted = 0; // the first ct_num_of_sorted entries of ct are sorted
+	void sortCT() const; // merge the appended constraints into the sorted ones
 	int ct_max_timestep = 0;
     // typedef unordered_map<size_t, set< pair<int, int> > > CAT; // conflict avoidance table // location -> time range, or edge -> time range
-    typedef vector< vector<bool> > CAT;
+    // location -> the timesteps when other agents are at the location, as a bitset (bit t % 64 of word t / 64),
+    // so that the timesteps in a range are counted by popcount
+    typedef vector< vector<uint64_t> > CAT;
     CAT cat;
 	int cat_max_timestep = 0;
 	vector<int> cat_goals;
     map<int, size_t> landmarks; // <timestep, location>: the agent must be at the given location at the given timestep
 
     void insertLandmark(size_t loc, int t); // insert a landmark, i.e., the agent has to be at the given location at the given timestep
+    pair<CT::const_iterator, CT::const_iterator> getConstraints(size_t loc) const; // the time ranges at the location
+    inline bool isInCAT(size_t loc, int t) const
+    {
+        size_t word = (size_t)t / 64; // a negative t gives an out-of-range word
+        return word < cat[loc].size() and ((cat[loc][word] >> (t % 64)) & 1);
+    }
+    int getNumOfCATTimesteps(size_t loc, int t_min) const; // the number of timesteps in the CAT at or after t_min
 	list<pair<int, int> > decodeBarrier(int B1, int B2, int t) const;
 	inline size_t getEdgeIndex(size_t from, size_t to) const { return (1 + from) * map_size + to; }
 };
@@ -1,16 +1,32 @@
 #pragma once
+#include <random>
 #include "BasicLNS.h"
 
 enum init_destroy_heuristic { TARGET_BASED, COLLISION_BASED, RANDOM_BASED, INIT_COUNT };
 
+struct InitLNSWorker // a worker thread of parallel InitLNS
+{
+    Neighbor neighbor;
+    vector<Path> new_paths;
+    vector<bool> in_neighbor; // the agents that the worker replans, which its view of the shared path table ignores
+    PathTableWC new_path_table; // the new paths that the worker has planned so far in the current round
+    int selected_neighbor = 0; // the destroy heuristic that generated the neighbor
+    std::mt19937 random_generator; // shuffles the agents of the neighbor, as rand() must not be called by the workers
+    bool succ = false;
+    InitLNSWorker(int map_size, int num_of_agents, std::seed_seq& seeds) :
+        in_neighbor(num_of_agents, false), new_path_table(map_size, num_of_agents), random_generator(seeds) {}
+};
+
 class InitLNS : public BasicLNS
 {
 public:
     vector<Agent>& agents;
     int num_of_colliding_pairs = 0;
+    int num_of_rejected_repairs = 0; // parallel repairs that collide with the repairs of other workers
 
     InitLNS(const Instance& instance, vector<Agent>& agents, double time_limit,
-            const string & replan_algo_name, const string & init_destory_name, int neighbor_size, int screen);
+            const string & replan_algo_name, const string & init_destory_name, int neighbor_size, int screen,
+            int num_of_threads = 1);
 
     bool getInitialSolution();
     bool run();
@@ -25,6 +41,7 @@ public:
 private:
     string replan_algo_name;
     init_destroy_heuristic init_destroy_strategy = COLLISION_BASED;
+    int num_of_threads;
 
     PathTableWC path_table; // 1. stores the paths of all agents in a time-space table;
     // 2. avoid making copies of this variable as much as possible.
@@ -33,15 +50,31 @@ private:
     vector<int> goal_table;
 
 
+    void runIteration(); // destroy and repair one neighbor
     bool runPP();
     bool runGCBS();
     bool runPBS();
 
+    // parallel InitLNS: in every round, the workers replan disjoint neighbors, one for each of num_of_threads connected
+    // components of the collision graph, against their views of the path table, and the repairs are then merged one
+    // by one if they do not collide with the agents repaired by the other workers.
+    // A round with fewer components than threads runs a single iteration instead.
+    void runInParallel();
+    // return the number of neighbors, which is 0 if the collision graph has fewer components than threads
+    int generateDisjointNeighbors(vector<InitLNSWorker>& workers, vector<int>& owners);
+    bool runPP(InitLNSWorker& worker, double T);
+    bool mergeRepair(vector<InitLNSWorker>& workers, const vector<int>& owners, int k);
+
     bool updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path) const;
+    bool updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path,
+                              const PathTableWCView& table) const;
 
     void chooseDestroyHeuristicbyALNS();
 
     bool generateNeighborByCollisionGraph();
+    // select neighbor_size agents around the connected component G of the collision graph, skipping the taken agents
+    void generateNeighborInComponent(unordered_map<int, set<int>>& G, set<int>& neighbors_set,
+                                     const vector<int>& owners);
     bool generateNeighborByTarget();
     bool generateNeighborRandomly();
 
@@ -1,7 +1,27 @@
 #pragma once
+#include <memory>
+#include <mutex>
+#include <cassert>
 #include"common.h"
 
 
+// A range of locations that are stored contiguously, e.g., the neighbors of a location in the adjacency array of Instance
+class LocationRange
+{
+public:
+    LocationRange(const int* first, const int* last) : first(first), last(last) {}
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    int front() const { return *first; }
+    int back() const { return *(last - 1); }
+    int operator[](size_t i) const { return first[i]; }
+private:
+    const int* first;
+    const int* last;
+};
+
 // Currently only works for undirected unweighted 4-nighbor grids
 class Instance 
 {
@@ -23,31 +43,35 @@ public:
     vector<int> getGoals() const {return goal_locations;};
 
 
-    inline bool isObstacle(int loc) const { return my_map[loc]; }
-    inline bool validMove(int curr, int next) const
+    inline bool isObstacle(int loc) const { return !(free_moves[loc] & FREE); }
+    inline bool validMove(int curr, int next) const // curr has to be on the map, but next does not
     {
-        if (next < 0 || next >= map_size)
-            return false;
-        if (my_map[next])
-            return false;
-        return getManhattanDistance(curr, next) < 2;
+        assert(curr >= 0 && curr < map_size);
+        int diff = next - curr;
+        unsigned moves = free_moves[curr];
+        return (((diff == 0) & moves) | ((diff == 1) & (moves >> 1)) | ((diff == -1) & (moves >> 2)) |
+                ((diff == num_of_cols) & (moves >> 3)) | ((diff == -num_of_cols) & (moves >> 4))) & 1u;
+    }
+    // the neighbors of the location, which are iterated without allocating anything
+    LocationRange getNeighbors(int curr) const
+    {
+        return {neighbors.data() + neighbor_offsets[curr], neighbors.data() + neighbor_offsets[curr + 1] - 1};
+    }
+    LocationRange getNextLocations(int curr) const // including itself (at the end) and its neighbors
+    {
+        return {neighbors.data() + neighbor_offsets[curr], neighbors.data() + neighbor_offsets[curr + 1]};
     }
-    list<int> getNeighbors(int curr) const;
 
 
     inline int linearizeCoordinate(int row, int col) const { return ( this->num_of_cols * row + col); }
-    inline int getRowCoordinate(int id) const { return id / this->num_of_cols; }
-    inline int getColCoordinate(int id) const { return id % this->num_of_cols; }
-    inline pair<int, int> getCoordinate(int id) const { return make_pair(id / this->num_of_cols, id % this->num_of_cols); }
+    inline int getRowCoordinate(int id) const { return coordinates[id].first; }
+    inline int getColCoordinate(int id) const { return coordinates[id].second; }
+    inline pair<int, int> getCoordinate(int id) const { return coordinates[id]; }
     inline int getCols() const { return num_of_cols; }
 
     inline int getManhattanDistance(int loc1, int loc2) const
     {
-        int loc1_x = getRowCoordinate(loc1);
-        int loc1_y = getColCoordinate(loc1);
-        int loc2_x = getRowCoordinate(loc2);
-        int loc2_y = getColCoordinate(loc2);
-        return abs(loc1_x - loc2_x) + abs(loc1_y - loc2_y);
+        return getManhattanDistance(coordinates[loc1], coordinates[loc2]);
     }
 
     static inline int getManhattanDistance(const pair<int, int>& loc1, const pair<int, int>& loc2)
@@ -57,30 +81,39 @@ public:
 
 	int getDegree(int loc) const
 	{
-		assert(loc >= 0 && loc < map_size && !my_map[loc]);
-		int degree = 0;
-		if (0 <= loc - num_of_cols && !my_map[loc - num_of_cols])
-			degree++;
-		if (loc + num_of_cols < map_size && !my_map[loc + num_of_cols])
-			degree++;
-		if (loc % num_of_cols > 0 && !my_map[loc - 1])
-			degree++;
-		if (loc % num_of_cols < num_of_cols - 1 && !my_map[loc + 1])
-			degree++;
-		return degree;
+		assert(loc >= 0 && loc < map_size && !isObstacle(loc));
+		return __builtin_popcount(free_moves[loc] >> 1);
 	}
 
 	int getDefaultNumberOfAgents() const { return num_of_agents; }
 	string getInstanceName() const { return agent_fname; }
     void savePaths(const string & file_name, const vector<Path*>& paths) const;
     bool validateSolution(const vector<Path*>& paths, int sum_of_costs, int num_of_colliding_pairs) const;
+
+    // the distances from all locations to the goal location. They are computed at the first call and then shared
+    // by all agents (and all their solvers) with the same goal location, so the memory grows with the number of
+    // distinct goal locations rather than the number of agents. It is safe to call from several threads.
+    const int* getDistances(int goal_location) const; // indexed by location
+    void precomputeDistances(int num_of_threads) const; // compute the distances to the goal locations of all agents
+    // Keep the distances in files under the given directory, one per goal location, so that later runs on the same map
+    // (with the same content, whatever its file name) map them into memory instead of computing them again.
+    // The files are written when the distances are computed for the first time.
+    void setDistanceCache(const string& directory);
+    void setRandomSeed(int seed) { random_seed = seed; } // the --seed of the run
+    int getRandomSeed() const { return random_seed; }
 private:
 	  // int moves_offset[MOVE_COUNT];
 	  vector<bool> my_map;
+	  vector<pair<int, int> > coordinates; // the row and column of each location
+	  // the moves that can be made from each location: bit FREE is set iff the location is not an obstacle,
+	  // and bit EAST (WEST, SOUTH, NORTH) is set iff the neighbor in that direction is on the map and not an obstacle
+	  enum move_bits : uint8_t { FREE = 1, EAST = 2, WEST = 4, SOUTH = 8, NORTH = 16 };
+	  vector<uint8_t> free_moves;
 	  string map_fname;
 	  string agent_fname;
 
 	  int num_of_agents;
+	  int random_seed = 0;
 	  vector<int> start_locations;
 	  vector<int> goal_locations;
 
@@ -100,6 +133,31 @@ private:
 
 	  int randomWalk(int loc, int steps) const;
 
+	  // the adjacency array: the neighbors of location loc are neighbors[neighbor_offsets[loc]], ...,
+	  // neighbors[neighbor_offsets[loc + 1] - 2], followed by loc itself (for wait actions)
+	  vector<int> neighbor_offsets;
+	  vector<int> neighbors;
+	  void resizeMap(int rows, int cols); // an empty map
+	  void buildNeighbors(); // the free moves and the adjacency array, after the map is generated or loaded
+
+	  struct DistanceRow
+	  {
+	      std::once_flag computed;
+	      const int* data = nullptr; // points to distances or into the mapped cache file
+	      vector<int> distances;
+	      void* mapped_data = nullptr; // the mapped cache file, including its header
+	      size_t mapped_size = 0;
+	      ~DistanceRow();
+	  };
+	  mutable vector< std::unique_ptr<DistanceRow> > distance_table; // goal location -> distances, allocated on demand
+	  mutable std::mutex distance_table_mutex; // guards the allocation of the rows
+	  string distance_cache; // the directory of the cache files of this map, or empty if there is no cache
+	  uint64_t map_hash = 0; // set together with distance_cache
+	  void computeDistances(int goal_location, vector<int>& distances) const;
+	  bool loadDistances(int goal_location, DistanceRow& row) const;
+	  void saveDistances(int goal_location, const vector<int>& distances) const;
+	  uint64_t getMapHash() const;
+
 	  // Class  SingleAgentSolver can access private members of Node 
 	  friend class SingleAgentSolver;
 };
@@ -1,6 +1,12 @@
 #pragma once
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <random>
 #include "BasicLNS.h"
 #include "InitLNS.h"
+#include "ConcurrentPathTable.h"
 
 //pibt related
 #include "simplegrid.h"
@@ -11,11 +17,72 @@
 #include "pps.h"
 #include "winpibt.h"
 
+class ECBS;
+
+#define PORTFOLIO_PP_RUNS 3 // number of random orders that PP tries in the portfolio, each on its own thread
+// the PIBT members of the portfolio are skipped on maps where their all-pairs distance matrix would need more bytes
+#define PORTFOLIO_PIBT_MAX_MEMORY ((size_t)512 << 20)
+// the minimum weight of an arm when the neighbor size is adaptive, so that the arms that have not improved
+// the solution recently are still tried from time to time
+#define MIN_ARM_WEIGHT 0.1
+
 enum destroy_heuristic { RANDOMAGENTS, RANDOMWALK, INTERSECTION, DESTORY_COUNT };
 
-// TODO: adaptively change the neighbor size, that is,
-// increase it if no progress is made for a while
-// decrease it if replanning fails to find any solutions for several times
+// a choice of adaptive LNS, i.e., a destroy heuristic with a neighbor size, and its statistics
+struct LNSArm
+{
+    destroy_heuristic heuristic;
+    int neighbor_size;
+    int num_of_selections = 0; // the iterations that replanned a neighbor generated by this arm
+    int num_of_improvements = 0;
+    int cost_reduction = 0;
+    double runtime = 0; // of these iterations
+    // the cost reduction and the runtime of the recent iterations, where the older ones are discounted by
+    // reaction_factor whenever the arm is selected, which give the weight of the arm if the neighbor size is adaptive
+    double recent_cost_reduction = 0;
+    double recent_runtime = 0;
+    LNSArm(destroy_heuristic heuristic, int neighbor_size) : heuristic(heuristic), neighbor_size(neighbor_size) {}
+};
+
+// the time limit of a repair, learned from the runtimes of the recent repairs with the same number of agents:
+// twice their 95th percentile, so that a repair that takes much longer than the successful ones is aborted.
+// A repair that times out counts as a repair that took the whole time limit, so the time limit grows back if
+// many repairs time out. Until there are enough repairs of a size, the time limit is the given maximum.
+// The limits are not keyed by the replan algorithm, as an LNS run uses a single one (replan_algo_name)
+// and every LNS has its own ReplanTimeLimits.
+class ReplanTimeLimits
+{
+public:
+    explicit ReplanTimeLimits(double max_time_limit = 0) : max_time_limit(max_time_limit) {}
+    double get(int neighbor_size) const
+    {
+        auto it = limits.find(neighbor_size);
+        return it == limits.end() ? max_time_limit : it->second.time_limit;
+    }
+    // record a repair of neighbor_size agents, where a failed repair is recorded only if it has timed out
+    void update(int neighbor_size, bool succ, double runtime);
+    void print() const;
+private:
+    static const int MIN_SAMPLES = 20;
+    static const int MAX_SAMPLES = 100; // only the recent repairs, as the repairs get harder in later iterations
+    double max_time_limit;
+    struct Limit
+    {
+        std::deque<double> runtimes;
+        double time_limit;
+        int num_of_timeouts = 0;
+    };
+    map<int, Limit> limits; // indexed by neighbor sizes
+};
+
+struct LNSWorker // a worker thread of parallel LNS
+{
+    Neighbor neighbor;
+    vector<Path> new_paths;
+    int selected_neighbor = 0;
+    vector<bool> in_neighbor; // the agents in the neighbor, which the worker ignores in the shared path table
+    std::mt19937 random_generator; // shuffles the agents of the neighbor, as rand() must not be called by the workers
+};
 
 class LNS : public BasicLNS
 {
@@ -27,11 +94,15 @@ public:
     int sum_of_costs_lowerbound = -1;
     int sum_of_distances = -1;
     int restart_times = 0;
+    int num_of_committed_repairs = 0; // parallel repairs that are committed to the shared path table
+    int num_of_rejected_repairs = 0; // parallel repairs that collide with the repairs committed by other workers
+    string portfolio_winner; // the member of the portfolio that found the initial solution
 
     LNS(const Instance& instance, double time_limit,
         const string & init_algo_name, const string & replan_algo_name, const string & destory_name,
         int neighbor_size, int num_of_iterations, bool init_lns, const string & init_destory_name, bool use_sipp,
-        int screen, PIBTPPS_option pipp_option);
+        int screen, PIBTPPS_option pipp_option, int num_of_threads = 1, bool adaptive_neighbor_size = false,
+        bool adaptive_replan_time = false);
     ~LNS()
     {
         delete init_lns;
@@ -48,10 +119,28 @@ private:
     string init_algo_name;
     string replan_algo_name;
     bool use_init_lns; // use LNS to find initial solutions
+    bool use_sipp; // the single-agent solvers are SIPP or SpaceTimeAStar
     destroy_heuristic destroy_strategy = RANDOMWALK;
     int num_of_iterations;
     string init_destory_name;
     PIBTPPS_option pipp_option;
+    int num_of_threads;
+
+    // adaptive LNS picks one of the arms by the roulette wheel over destroy_weights (which has a weight per arm).
+    // If the neighbor size is adaptive, the arms combine every destroy heuristic with several neighbor sizes,
+    // and the weight of an arm is its recent cost reduction per second divided by that of all arms, so that the arms
+    // with larger neighbors, which take longer to replan, have to reduce the cost by more, and an average arm has
+    // weight 1 like the initial weights. Every arm is selected once before the roulette wheel is used.
+    // Otherwise, the arms are the destroy heuristics with the given neighbor size, and the reward is the cost
+    // reduction per agent in the neighbor.
+    // The adaptive neighbor size is experimental and off by default, as it has not beaten a fixed size of 8.
+    bool adaptive_neighbor_size;
+    vector<LNSArm> arms;
+
+    // if adaptive_replan_time, the time limit of every repair is learned by replan_time_limits,
+    // and otherwise, it is always replan_time_limit
+    bool adaptive_replan_time;
+    ReplanTimeLimits replan_time_limits;
 
 
     PathTable path_table; // 1. stores the paths of all agents in a time-space table;
@@ -59,21 +148,56 @@ private:
     unordered_set<int> tabu_list; // used by randomwalk strategy
     list<int> intersections;
 
+    // parallel LNS: every worker replans its own neighbor against the shared path table, which other workers
+    // may update at the same time, and commits the new paths only if they do not collide with the current paths
+    std::mutex lns_mutex; // guards agents, path_table, neighbor, the commits to shared_path_table, and the statistics
+    ConcurrentPathTable* shared_path_table = nullptr; // a copy of path_table that the workers read without locking
+    vector<bool> in_repair; // agents that are being replanned by some worker
+    int num_of_running_repairs = 0; // the iterations that workers have started but not added to iteration_stats yet
+    std::condition_variable repair_finished; // notified whenever a worker releases the agents of its repair
+
     bool runEECBS();
     bool runCBS();
     bool runPP();
     bool runPIBT();
     bool runPPS();
     bool runWinPIBT();
+    // the following write the paths to the given vector, which is indexed by agent ids.
+    // Those that the portfolio runs on several threads shuffle the agents by the given generator instead of rand().
+    // plans all agents by the given solvers, where solvers[i] belongs to neighbor.agents[i], against its own path table
+    bool runPP(vector<Path>& paths, const vector< std::unique_ptr<SingleAgentSolver> >& solvers,
+               std::mt19937& random_generator, const std::atomic<bool>* stop_flag);
+    bool runPIBT(vector<Path>& paths, std::mt19937& random_generator, const std::atomic<bool>* stop_flag);
+    bool runPPS(vector<Path>& paths, const std::atomic<bool>* stop_flag);
+    bool runWinPIBT(vector<Path>& paths, std::mt19937& random_generator, const std::atomic<bool>* stop_flag);
+    void setUpEECBS(ECBS& ecbs) const;
+    // create new solvers for the agents in neighbor, so that the members of the portfolio do not share
+    // the solvers of the agents, where solvers[i] belongs to neighbor.agents[i]
+    void createSolvers(vector< std::unique_ptr<SingleAgentSolver> >& solvers) const;
+    void acceptInitialSolution(vector<Path>& paths);
+
+    // portfolio: run PP with several random orders (one thread each), EECBS, PIBT, and winPIBT at the same time,
+    // and the first solution wins
+    bool runPortfolio();
+
+    void runInParallel();
+    void runWorker(int worker_id);
+    bool runPP(LNSWorker& worker, const ReadOnlyPathTable& path_table, double time_limit,
+               const std::atomic<bool>* stop_flag = nullptr);
+    bool commitRepair(LNSWorker& worker);
 
 
     MAPF preparePIBTProblem(vector<int>& shuffled_agents);
-    void updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents);
+    void updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents, vector<Path>& paths);
 
     void chooseDestroyHeuristicbyALNS();
+    // update the weight and the statistics of the arm after it has generated and replanned the neighbor
+    void updateDestroyWeights(int arm, const Neighbor& nb, const high_resolution_clock::time_point& iteration_start);
+    void printArmStats() const;
 
     bool generateNeighborByRandomWalk();
     bool generateNeighborByIntersection();
+    bool generateNeighborRandomly();
 
     int findMostDelayedAgent();
     int findRandomAgent() const;
@@ -0,0 +1,121 @@
+#pragma once
+#include <cassert>
+#include "common.h"
+
+// A hash table that maps the nodes of a low-level search to values of type Value (e.g., the node that is
+// stored for them), where two nodes are duplicates if they agree on the location, the time given by Key::time,
+// wait_at_goal and is_goal. It uses open addressing with linear probing on a flat array of slots.
+// clear() only increases the generation number, which marks all slots as empty, so the slots that the previous search
+// has grown are reused by the next one without being freed and reallocated.
+template<class Node, class Key, class Value = Node*>
+class NodeTable
+{
+public:
+    size_t size() const { return num_of_entries; }
+
+    // return the value of the duplicates of the node, or nullptr if there is none
+    Value* find(const Node* node)
+    {
+        if (slots.empty())
+            return nullptr;
+        auto& slot = slots[findSlot(node)];
+        return slot.generation == generation ? &slot.value : nullptr;
+    }
+    // return the value of the duplicates of the node, which is value-initialized if there was none
+    Value& operator[](const Node* node)
+    {
+        if (2 * (num_of_entries + 1) > slots.size()) // keep the load factor at most 1/2
+            resize(max(MIN_SLOTS, 2 * slots.size()));
+        auto& slot = slots[findSlot(node)];
+        if (slot.generation != generation)
+        {
+            slot.generation = generation;
+            slot.location = node->location;
+            slot.time = Key::time(node);
+            slot.wait_at_goal = node->wait_at_goal;
+            slot.is_goal = node->is_goal;
+            slot.value = Value();
+            num_of_entries++;
+        }
+        return slot.value;
+    }
+    void insert(Node* node) { (*this)[node] = node; }
+
+    template<class Func>
+    void forEach(Func func) const // call func on the value of every entry
+    {
+        for (const auto& slot : slots)
+        {
+            if (slot.generation == generation)
+                func(slot.value);
+        }
+    }
+
+    void clear()
+    {
+        num_of_entries = 0;
+        generation++;
+        if (generation == 0) // the generation number has wrapped around, so the old ones could be taken as current
+        {
+            for (auto& slot : slots)
+                slot.generation = 0;
+            generation = 1;
+        }
+    }
+
+private:
+    static const size_t MIN_SLOTS = 64;
+    struct Slot
+    {
+        Value value;
+        int location;
+        int time;
+        unsigned generation = 0; // the slot is in use iff it equals the current generation
+        bool wait_at_goal;
+        bool is_goal;
+    };
+    vector<Slot> slots; // the size is a power of 2
+    unsigned generation = 1;
+    size_t num_of_entries = 0;
+
+    static size_t getHash(int location, int time) // Fibonacci hashing
+    {
+        uint64_t key = ((uint64_t)(unsigned)location << 32) | (unsigned)time;
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    // return the slot of the duplicates of the node, or the empty slot where they should be inserted
+    size_t findSlot(const Node* node) const
+    {
+        int time = Key::time(node);
+        size_t mask = slots.size() - 1;
+        for (size_t i = getHash(node->location, time) & mask; ; i = (i + 1) & mask)
+        {
+            const auto& slot = slots[i];
+            if (slot.generation != generation or
+                (slot.location == node->location and slot.time == time and
+                 slot.wait_at_goal == node->wait_at_goal and slot.is_goal == node->is_goal))
+                return i;
+        }
+    }
+
+    void resize(size_t num_of_slots)
+    {
+        assert((num_of_slots & (num_of_slots - 1)) == 0);
+        vector<Slot> old_slots(num_of_slots);
+        std::swap(slots, old_slots);
+        size_t mask = num_of_slots - 1;
+        for (const auto& old_slot : old_slots)
+        {
+            if (old_slot.generation != generation)
+                continue;
+            size_t i = getHash(old_slot.location, old_slot.time) & mask;
+            while (slots[i].generation == generation)
+                i = (i + 1) & mask;
+            slots[i] = old_slot;
+        }
+    }
+};
+
+template<class Node, class Key, class Value>
+const size_t NodeTable<Node, Key, Value>::MIN_SLOTS;
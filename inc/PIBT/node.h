@@ -17,6 +17,7 @@ private:
 public:
   Node();
   Node(int _id);
+  Node(int _id, int _index);  // index local to the owning graph
   ~Node() {};
 
   std::vector<Node*> getNeighbor() { return neighbor; }
@@ -25,6 +25,7 @@ private:
 public:
     PIBT_Agent();
     PIBT_Agent(Node* v);  // initial location
+    PIBT_Agent(Node* v, int _id);  // initial location, id local to the problem
     ~PIBT_Agent();
 
     int getId() { return id; }
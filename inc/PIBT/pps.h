@@ -50,7 +50,7 @@ private:
   std::vector<bool> isTmpGoals;  // has temp goal
   Nodes deg3nodes;
 
-  static int s_uuid;
+  int s_uuid = 0;  // local to the solver, as solvers may run concurrently
 
   void init();
 
@@ -2,6 +2,7 @@
 
 #include "problem.h"
 #include <vector>
+#include <atomic>
 #include <algorithm>
 #include <chrono>
 #include <eigen3/Eigen/Core>
@@ -40,6 +41,8 @@ protected:
   std::chrono::system_clock::time_point startT;
   std::chrono::system_clock::time_point endT;
   double time_limit=0;
+  const std::atomic<bool>* stop_flag=nullptr;
+  bool stopped() const { return stop_flag != nullptr && *stop_flag; }
 
 public:
   Solver(Problem* _P);
@@ -48,6 +51,7 @@ public:
 
   void WarshallFloyd();
   void setTimeLimit(double limit){this->time_limit=limit;};
+  void setStopFlag(const std::atomic<bool>* flag){this->stop_flag=flag;};
 
 
     virtual bool solve() { return false; };
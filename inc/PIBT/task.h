@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
 #include "node.h"
 
 
@@ -10,7 +11,7 @@ private:
   std::vector<Node*> G_CLOSE;  // finished nodes
 
   const int id;
-  static int cntId;  // for uuid
+  static std::atomic<int> cntId;  // for uuid, shared by the problems that the portfolio builds concurrently
 
   int startTime;  // timestep
   int endTime;
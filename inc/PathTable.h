@@ -1,47 +1,419 @@
 #pragma once
+#include <algorithm>
 #include "common.h"
 
 #define NO_AGENT -1
 
-class PathTable
+typedef tuple<int, int, bool> Interval; // [t_min, t_max), has collision
+
+// a maximal interval [t_min, t_max) during which an agent stays at a location
+struct AgentInterval
+{
+    int t_min;
+    int t_max;
+    int agent;
+    AgentInterval(int t_min = 0, int t_max = 0, int agent = NO_AGENT) : t_min(t_min), t_max(t_max), agent(agent) {}
+};
+
+// The numbers of paths that reach their goals at each timestep, which give the makespan after a deletion
+// without a scan of the goal times of all locations. The non-empty goal times are kept in a bitset with
+// one summary bit per 64-bit word, so a deletion of the longest path finds the next longest one by reading
+// a few words instead of walking down through the gap. An insertion takes O(1) time, and a deletion
+// takes O(1 + gap / 4096) time, where gap is the difference between the longest and the second longest goal times.
+class GoalTimeCounter
 {
 public:
+    void insert(int goal_time)
+    {
+        if ((int) counts.size() <= goal_time)
+        {
+            counts.resize(goal_time + 1, 0);
+            words.resize(goal_time / 64 + 1, 0);
+            summary.resize(goal_time / 4096 + 1, 0);
+        }
+        if (counts[goal_time]++ == 0)
+        {
+            words[goal_time / 64] |= 1ULL << (goal_time % 64);
+            summary[goal_time / 4096] |= 1ULL << (goal_time / 64 % 64);
+        }
+        makespan = max(makespan, goal_time);
+    }
+    void erase(int goal_time)
+    {
+        assert(counts[goal_time] > 0);
+        if (--counts[goal_time] > 0)
+            return;
+        words[goal_time / 64] &= ~(1ULL << (goal_time % 64));
+        if (words[goal_time / 64] == 0)
+            summary[goal_time / 4096] &= ~(1ULL << (goal_time / 64 % 64));
+        if (goal_time == makespan)
+            makespan = findLast(goal_time);
+    }
+    int getMakespan() const { return makespan; }
+    void clear() { counts.clear(); words.clear(); summary.clear(); makespan = 0; }
+
+private:
+    vector<int> counts; // key is the timestep, value is the number of paths that reach their goals at the timestep
+    vector<uint64_t> words; // bit t is set iff counts[t] > 0
+    vector<uint64_t> summary; // bit w is set iff words[w] != 0
     int makespan = 0;
-    vector< vector<int> > table; // this stores the collision-free paths, the value is the id of the agent
-    vector<int> goals; // this stores the goal locatons of the paths: key is the location, while value is the timestep when the agent reaches the goal
-    void reset() { auto map_size = table.size(); table.clear(); table.resize(map_size); goals.assign(map_size, MAX_COST); makespan = 0; }
+
+    int findLast(int t) const // return the largest non-empty goal time <= t, or 0 if there is none
+    {
+        int w = t / 64;
+        uint64_t bits = words[w] & (~0ULL >> (63 - t % 64));
+        if (bits != 0)
+            return w * 64 + 63 - __builtin_clzll(bits);
+        int s = w / 64;
+        bits = w % 64 == 0 ? 0 : summary[s] & (~0ULL >> (64 - w % 64)); // the words before w
+        while (bits == 0)
+        {
+            if (s == 0)
+                return 0;
+            bits = summary[--s];
+        }
+        w = s * 64 + 63 - __builtin_clzll(bits);
+        return w * 64 + 63 - __builtin_clzll(words[w]);
+    }
+};
+
+// The read access to a collision-free path table, for the users that may get either a PathTable,
+// a ConcurrentPathTable or a view of one of them, e.g., through ConstraintTable::path_table_for_CT
+class ReadOnlyPathTable
+{
+public:
+    virtual bool constrained(int from, int to, int to_time) const = 0;
+    virtual int getHoldingTime(int location, int earliest_timestep) const = 0;
+    virtual bool empty() const = 0;
+    virtual int getMakespan() const = 0;
+    virtual int getLength(int location) const = 0; // all cells after it are free
+    virtual int getAgent(int location, int timestep) const = 0; // return NO_AGENT if the cell is free
+    virtual int getGoalTime(int location) const = 0;
+    // append the intervals of the agents at the location to intervals in increasing order of time
+    virtual void getIntervals(int location, vector<AgentInterval>& intervals) const = 0;
+    // return the safe intervals at the location that avoid all paths in the table (up to MAX_TIMESTEP),
+    // or nullptr if the table does not keep them. They are updated whenever paths are inserted or deleted,
+    // so that the ReservationTables of all SIPP searches can share them.
+    virtual const vector<Interval>* getSafeIntervals(int location) const = 0;
+    virtual ~ReadOnlyPathTable() = default;
+
+protected:
+    // the queries shared by the derived path tables, written in terms of their cell accessors
+    template <class T>
+    static bool constrainedByCells(const T& path_table, int from, int to, int to_time)
+    {
+        if (path_table.getAgent(to, to_time) != NO_AGENT)
+            return true;  // vertex conflict
+        if (to_time > 0)
+        {
+            auto agent = path_table.getAgent(to, to_time - 1);
+            if (agent != NO_AGENT and agent == path_table.getAgent(from, to_time))
+                return true;  // edge conflict
+        }
+        return path_table.getGoalTime(to) <= to_time; // target conflict
+    }
+    template <class T>
+    static int getHoldingTimeByCells(const T& path_table, int location, int earliest_timestep)
+    {
+        int rst = path_table.getLength(location);
+        if (rst <= earliest_timestep)
+            return earliest_timestep;
+        while (rst > earliest_timestep and path_table.getAgent(location, rst - 1) == NO_AGENT)
+            rst--;
+        return rst;
+    }
+    template <class T>
+    static void getIntervalsByCells(const T& path_table, int location, vector<AgentInterval>& intervals)
+    {
+        int length = path_table.getLength(location);
+        for (int t = 0; t < length;)
+        {
+            int agent = path_table.getAgent(location, t);
+            int t_min = t++;
+            while (t < length and path_table.getAgent(location, t) == agent)
+                t++;
+            if (agent != NO_AGENT)
+                intervals.emplace_back(t_min, t, agent);
+        }
+    }
+};
+
+// The paths are stored as the intervals during which the agents stay at the locations, i.e., run-length encoded,
+// because most locations are occupied at only a few of the timesteps up to the makespan.
+// The intervals of all locations are stored in one contiguous array instead of one vector per location.
+// The intervals of a location are contiguous in the array and sorted by time, and the header of the row
+// (where the row is, its size and the goal time at the location) is a single small struct,
+// so no memory is allocated or freed per location when rows grow or the table is reset.
+class PathTable final : public ReadOnlyPathTable
+{
+public:
+    int makespan = 0;
+    void reset();
     void insertPath(int agent_id, const Path& path);
     void deletePath(int agent_id, const Path& path);
-    bool constrained(int from, int to, int to_time) const;
+    bool constrained(int from, int to, int to_time) const override;
+    bool hasCollisions(const Path& path) const; // return true if the path collides with any path in the table
 
     void get_agents(set<int>& conflicting_agents, int loc) const;
     void get_agents(set<int>& conflicting_agents, int neighbor_size, int loc) const;
     void getConflictingAgents(int agent_id, set<int>& conflicting_agents, int from, int to, int to_time) const;;
-    int getHoldingTime(int location, int earliest_timestep) const;
-    explicit PathTable(int map_size = 0) : table(map_size), goals(map_size, MAX_COST) {}
+    int getHoldingTime(int location, int earliest_timestep) const override;
+
+    bool empty() const override { return rows.empty(); }
+    int getMakespan() const override { return makespan; }
+    int getLength(int location) const override
+    {
+        const auto& row = rows[location];
+        return row.size == 0 ? 0 : intervals[row.offset + row.size - 1].t_max;
+    }
+    int getAgent(int location, int timestep) const override
+    {
+        const auto& row = rows[location];
+        auto first = intervals.begin() + row.offset;
+        auto it = std::upper_bound(first, first + row.size, timestep,
+                                   [](int t, const AgentInterval& interval) { return t < interval.t_min; });
+        return (it != first and timestep < (it - 1)->t_max) ? (it - 1)->agent : NO_AGENT;
+    }
+    int getGoalTime(int location) const override { return rows[location].goal_time; }
+    void getIntervals(int location, vector<AgentInterval>& intervals) const override;
+    const vector<Interval>* getSafeIntervals(int location) const override;
+
+    // keep_safe_intervals is only worth its memory for long-lived tables that many searches read, e.g., the one of LNS
+    explicit PathTable(int map_size = 0, bool keep_safe_intervals = false) :
+        rows(map_size), safe_intervals(keep_safe_intervals ? map_size : 0) {}
+
+private:
+    static const int MIN_ROW_CAPACITY = 4;
+    struct Row
+    {
+        int offset = 0; // the index of the first interval of the row in intervals
+        int size = 0;
+        int capacity = 0;
+        int goal_time = MAX_TIMESTEP; // the timestep when the agent whose goal is the location reaches it
+    };
+    vector<Row> rows;
+    vector<AgentInterval> intervals;
+    int num_of_unused_intervals = 0; // the intervals left behind by the rows that have moved
+    GoalTimeCounter goal_time_counter;
+    vector< vector<Interval> > safe_intervals; // empty if not kept; only valid for the locations that are visited by any path
+
+    void reserve(Row& row, int size); // grow the row to at least the given size
+    void insertInterval(int location, const AgentInterval& interval);
+    void deleteInterval(int location, const AgentInterval& interval);
+    void updateSafeIntervals(const Path& path); // at the locations of the path
+    void updateSafeIntervals(int location);
+    void compact();
 };
 
-class PathTableWC // with collisions
+// The agents at a space-time cell of PathTableWC, in the order of insertion.
+// Up to INLINE_CAPACITY agents are stored in place (the cell takes 16 bytes, while an empty std::list takes 24),
+// so only the cells where many agents collide allocate memory.
+class AgentCell
+{
+public:
+    AgentCell() = default;
+    AgentCell(const AgentCell& other) { copy(other); }
+    AgentCell(AgentCell&& other) noexcept { move(other); }
+    AgentCell& operator=(const AgentCell& other)
+    {
+        if (this != &other) { release(); copy(other); }
+        return *this;
+    }
+    AgentCell& operator=(AgentCell&& other) noexcept
+    {
+        if (this != &other) { release(); move(other); }
+        return *this;
+    }
+    ~AgentCell() { release(); }
+
+    const int* begin() const { return data(); }
+    const int* end() const { return data() + num_of_agents; }
+    int front() const { return data()[0]; }
+    size_t size() const { return num_of_agents; }
+    bool empty() const { return num_of_agents == 0; }
+    void push_back(int agent)
+    {
+        if (num_of_agents == capacity)
+            grow();
+        data()[num_of_agents++] = agent;
+    }
+    void remove(int agent) // remove the first occurrence of the agent
+    {
+        auto* agents = data();
+        auto it = std::find(agents, agents + num_of_agents, agent);
+        if (it == agents + num_of_agents)
+            return;
+        std::copy(it + 1, agents + num_of_agents, it);
+        num_of_agents--;
+    }
+
+private:
+    static const int INLINE_CAPACITY = 2;
+    int num_of_agents = 0;
+    int capacity = INLINE_CAPACITY;
+    union
+    {
+        int inline_agents[INLINE_CAPACITY];
+        int* heap_agents;
+    };
+
+    int* data() { return capacity == INLINE_CAPACITY ? inline_agents : heap_agents; }
+    const int* data() const { return capacity == INLINE_CAPACITY ? inline_agents : heap_agents; }
+    void grow()
+    {
+        int new_capacity = 2 * capacity;
+        auto* agents = new int[new_capacity];
+        std::copy(data(), data() + num_of_agents, agents);
+        release();
+        heap_agents = agents;
+        capacity = new_capacity;
+    }
+    void release()
+    {
+        if (capacity != INLINE_CAPACITY)
+            delete[] heap_agents;
+        capacity = INLINE_CAPACITY;
+    }
+    void copy(const AgentCell& other)
+    {
+        if (other.capacity != INLINE_CAPACITY)
+        {
+            heap_agents = new int[other.capacity];
+            capacity = other.capacity;
+        }
+        num_of_agents = other.num_of_agents;
+        std::copy(other.begin(), other.end(), data());
+    }
+    void move(AgentCell& other)
+    {
+        num_of_agents = other.num_of_agents;
+        if (other.capacity == INLINE_CAPACITY)
+            std::copy(other.begin(), other.end(), inline_agents);
+        else
+        {
+            heap_agents = other.heap_agents;
+            capacity = other.capacity;
+            other.capacity = INLINE_CAPACITY;
+        }
+        other.num_of_agents = 0;
+    }
+};
+
+// The read access to a path table with collisions, for the users that may get either the table itself or a view of it,
+// e.g., through ConstraintTable::path_table_for_CAT
+class ReadOnlyPathTableWC
+{
+public:
+    virtual int getFutureNumOfCollisions(int loc, int time) const = 0; // return #collisions when the agent waiting at loc starting from time forever
+    virtual int getNumOfCollisions(int from, int to, int to_time) const = 0;
+    virtual bool hasCollisions(int from, int to, int to_time) const = 0;
+    virtual bool hasEdgeCollisions(int from, int to, int to_time) const = 0;
+    virtual int getLastCollisionTimestep(int location) const = 0;
+    virtual bool empty() const = 0;
+    virtual int getMakespan() const = 0;
+    virtual int getLength(int location) const = 0; // all cells after it are free
+    virtual int getNumOfAgents(int location, int timestep) const = 0;
+    virtual int getGoalTime(int location) const = 0;
+    virtual const Path* getPath(int agent_id) const = 0;
+    virtual ~ReadOnlyPathTableWC() = default;
+};
+
+class PathTableWC final : public ReadOnlyPathTableWC // with collisions
 {
 public:
     int makespan = 0;
-    vector< vector< list<int> > > table; // this stores the paths, the value is the id of the agent
+    vector< vector<AgentCell> > table; // this stores the paths, the value is the id of the agent
     vector<int> goals; // this stores the goal locatons of the paths: key is the location, while value is the timestep when the agent reaches the goal
-    void reset() { auto map_size = table.size(); table.clear(); table.resize(map_size); goals.assign(map_size, MAX_COST); makespan = 0; }
+    void reset()
+    {
+        auto map_size = table.size(); table.clear(); table.resize(map_size); goals.assign(map_size, MAX_COST);
+        goal_agents.assign(map_size, NO_AGENT); goal_time_counter.clear(); makespan = 0;
+    }
     void insertPath(int agent_id, const Path& path);
     void insertPath(int agent_id);
     void deletePath(int agent_id);
-    const Path* getPath(int agent_id) const {return paths[agent_id]; }
-    int getFutureNumOfCollisions(int loc, int time) const; // return #collisions when the agent waiting at loc starting from time forever
-    int getNumOfCollisions(int from, int to, int to_time) const;
-    bool hasCollisions(int from, int to, int to_time) const;
-    bool hasEdgeCollisions(int from, int to, int to_time) const;
-    int getLastCollisionTimestep(int location) const;
+    int getFutureNumOfCollisions(int loc, int time) const override;
+    int getNumOfCollisions(int from, int to, int to_time) const override;
+    bool hasCollisions(int from, int to, int to_time) const override;
+    bool hasEdgeCollisions(int from, int to, int to_time) const override;
+    int getLastCollisionTimestep(int location) const override;
     // return the agent who reaches its target target_location before timestep earliest_timestep
     int getAgentWithTarget(int target_location, int latest_timestep) const;
     void clear();
+
+    bool empty() const override { return table.empty(); }
+    int getMakespan() const override { return makespan; }
+    int getLength(int location) const override { return (int)table[location].size(); }
+    int getNumOfAgents(int location, int timestep) const override
+    {
+        return timestep < (int)table[location].size() ? (int)table[location][timestep].size() : 0;
+    }
+    int getGoalTime(int location) const override { return goals[location]; }
+    const Path* getPath(int agent_id) const override { return paths[agent_id]; }
+    int getGoalAgent(int location) const { return goal_agents[location]; } // the agent whose goal is the location
+    template <class F>
+    void forEachAgent(int location, int timestep, F visit) const // call visit(agent) for every agent at the cell
+    {
+        if (timestep >= 0 and timestep < (int)table[location].size())
+            for (int agent : table[location][timestep])
+                visit(agent);
+    }
+
     explicit PathTableWC(int map_size = 0, int num_of_agents = 0) : table(map_size), goals(map_size, MAX_COST),
-        paths(num_of_agents, nullptr) {}
+        paths(num_of_agents, nullptr), goal_agents(map_size, NO_AGENT) {}
 private:
     vector<const Path*> paths;
-};
\ No newline at end of file
+    vector<int> goal_agents; // key is the location, while value is the agent whose path ends there
+    GoalTimeCounter goal_time_counter;
+};
+
+// A read-only view of a path table with collisions that ignores the paths of the given agents
+// and sees the paths in overlay instead, e.g., the new paths of the agents that the caller is replanning.
+// The overlay must only contain the paths of ignored agents.
+class PathTableWCView final : public ReadOnlyPathTableWC
+{
+public:
+    PathTableWCView(const PathTableWC& path_table, const vector<bool>& ignored, const PathTableWC& overlay) :
+        path_table(path_table), ignored(ignored), overlay(overlay) {}
+
+    int getFutureNumOfCollisions(int loc, int time) const override;
+    int getNumOfCollisions(int from, int to, int to_time) const override;
+    bool hasCollisions(int from, int to, int to_time) const override
+    {
+        return getNumOfCollisions(from, to, to_time) > 0;
+    }
+    bool hasEdgeCollisions(int from, int to, int to_time) const override
+    {
+        return getNumOfEdgeCollisions(from, to, to_time) > 0;
+    }
+    int getLastCollisionTimestep(int location) const override;
+
+    bool empty() const override { return path_table.empty(); }
+    // an upper bound, as the ignored paths may be the longest ones
+    int getMakespan() const override { return max(path_table.getMakespan(), overlay.getMakespan()); }
+    int getLength(int location) const override { return max(path_table.getLength(location), overlay.getLength(location)); }
+    int getNumOfAgents(int location, int timestep) const override
+    {
+        int rst = 0;
+        forEachAgent(location, timestep, [&rst](int) { rst++; });
+        return rst;
+    }
+    int getGoalTime(int location) const override;
+    const Path* getPath(int agent_id) const override
+    {
+        return ignored[agent_id] ? overlay.getPath(agent_id) : path_table.getPath(agent_id);
+    }
+    template <class F>
+    void forEachAgent(int location, int timestep, F visit) const
+    {
+        path_table.forEachAgent(location, timestep, [&](int agent) { if (!ignored[agent]) visit(agent); });
+        overlay.forEachAgent(location, timestep, visit);
+    }
+
+private:
+    const PathTableWC& path_table;
+    const vector<bool>& ignored;
+    const PathTableWC& overlay;
+
+    int getNumOfEdgeCollisions(int from, int to, int to_time) const;
+};
@@ -2,15 +2,14 @@
 #pragma once
 #include "ConstraintTable.h"
 
-typedef tuple<int, int, bool> Interval; // [t_min, t_max), has collision
-
 class ReservationTable
 {
 public:
     const ConstraintTable& constraint_table;
 
     ReservationTable(const ConstraintTable& constraint_table, int goal_location) :
-        constraint_table(constraint_table), goal_location(goal_location), sit(constraint_table.map_size) {}
+        constraint_table(constraint_table), goal_location(goal_location), sit(constraint_table.map_size),
+        use_shared_sit(canShareSIT()) {}
 
     list<tuple<int, int, int, bool, bool> > get_safe_intervals(int from, int to, int lower_bound, int upper_bound);
     Interval get_first_safe_interval(size_t location);
@@ -21,6 +20,15 @@ private:
 	// Safe Interval Table (SIT)
 	typedef vector< list<Interval> > SIT;
     SIT sit; // location -> [t_min, t_max), num_of_collisions
+    vector<AgentInterval> intervals; // the buffer for the intervals of the path table
+    // if the agent is constrained only by path_table_for_CT at most of the locations,
+    // we use the safe intervals cached by the path table there instead of building our own
+    bool use_shared_sit;
+    bool canShareSIT() const;
+    const vector<Interval>* getSharedSIT(int location) const;
+    template<class Intervals>
+    list<tuple<int, int, int, bool, bool> > get_safe_intervals(int from, int to, int lower_bound, int upper_bound,
+                                                               const Intervals& safe_intervals) const;
     void insert2SIT(int location, int t_min, int t_max);
     void insertSoftConstraint2SIT(int location, int t_min, int t_max);
 	// void mergeIntervals(list<Interval >& intervals) const;
@@ -1,19 +1,18 @@
 ﻿#pragma once
-#include <boost/functional/hash.hpp>
 #include "SingleAgentSolver.h"
 #include "ReservationTable.h"
+#include "NodeTable.h"
 
 class SIPPNode: public LLNode
 {
 public:
-	// define a typedefs for handles to the heaps (allow up to quickly update a node in the heap)
-	typedef boost::heap::pairing_heap< SIPPNode*, compare<SIPPNode::compare_node> >::handle_type open_handle_t;
-	typedef boost::heap::pairing_heap< SIPPNode*, compare<SIPPNode::secondary_compare_node> >::handle_type focal_handle_t;
-	open_handle_t open_handle;
-	focal_handle_t focal_handle;
+	// the positions in the OPEN and FOCAL lists (allow us to quickly update a node in the lists)
+	BucketQueueHandle open_handle;
+	BucketQueueHandle focal_handle;
 	int high_generation; // the upper bound with respect to generation
     int high_expansion; // the upper bound with respect to expansion
 	bool collision_v;
+	SIPPNode* next_duplicate = nullptr; // in the list of duplicates in the hash table
     SIPPNode() : LLNode() {}
 	SIPPNode(int loc, int g_val, int h_val, SIPPNode* parent, int timestep, int high_generation, int high_expansion,
 	        bool collision_v, int num_of_conflicts) :
@@ -21,7 +20,6 @@ public:
             high_expansion(high_expansion), collision_v(collision_v) {}
 	// SIPPNode(const SIPPNode& other): LLNode(other), high_generation(other.high_generation), high_expansion(other.high_expansion),
         //                              collision_v(other.collision_v) {}
-	~SIPPNode() {}
 
 	void copy(const SIPPNode& other) // copy everything except for handles
     {
@@ -30,33 +28,11 @@ public:
         high_expansion = other.high_expansion;
         collision_v = other.collision_v;
     }
-	// The following is used by for generating the hash value of a nodes
-	struct NodeHasher
+	// two nodes are duplicates if they agree on the location, the interval (identified by high_generation),
+	// wait_at_goal and is_goal
+	struct duplicate_key
 	{
-		std::size_t operator()(const SIPPNode* n) const
-		{
-            size_t seed = 0;
-            boost::hash_combine(seed, n->location);
-            boost::hash_combine(seed, n->high_generation);
-            return seed;
-		}
-	};
-
-	// The following is used for checking whether two nodes are equal
-	// we say that two nodes, s1 and s2, are equal if
-	// both are non-NULL and agree on the id and timestep
-	struct eqnode
-	{
-		bool operator()(const SIPPNode* n1, const SIPPNode* n2) const
-		{
-			return (n1 == n2) ||
-			            (n1 && n2 && n1->location == n2->location &&
-				        n1->wait_at_goal == n2->wait_at_goal &&
-				        n1->is_goal == n2->is_goal &&
-                         n1->high_generation == n2->high_generation);
-                        //max(n1->timestep, n2->timestep) <
-                        //min(get<1>(n1->interval), get<1>(n2->interval))); //overlapping time intervals
-		}
+		static int time(const SIPPNode* n) { return n->high_generation; }
 	};
 };
 
@@ -74,25 +50,38 @@ public:
 		const vector<Path*>& paths, int agent, int lowerbound);
 	pair<Path, int> findSuboptimalPath(const HLNode& node, const ConstraintTable& initial_constraints,
 		const vector<Path*>& paths, int agent, int lowerbound, double w);  // return the path and the lowerbound
-    Path findPath(const ConstraintTable& constraint_table); // return A path that minimizes collisions, breaking ties by cost
+    using SingleAgentSolver::findPath;
+    // find a path that minimizes collisions, breaking ties by cost
+    void findPath(const ConstraintTable& constraint_table, Path& path, int upper_bound);
     int getTravelTime(int start, int end, const ConstraintTable& constraint_table, int upper_bound);
 
 	string getName() const { return "SIPP"; }
 
 	SIPP(const Instance& instance, int agent):
-		SingleAgentSolver(instance, agent) {}
+		SingleAgentSolver(instance, agent)
+	{
+		open_random_generator.seed(getTieBreakingSeed(agent, 0)); // break ties in the same way in every run with the same seed
+		focal_random_generator.seed(getTieBreakingSeed(agent, 1));
+	}
 
 private:
-	// define typedefs and handles for heap
-	typedef boost::heap::pairing_heap< SIPPNode*, boost::heap::compare<LLNode::compare_node> > heap_open_t;
-	typedef boost::heap::pairing_heap< SIPPNode*, boost::heap::compare<LLNode::secondary_compare_node> > heap_focal_t;
-	heap_open_t open_list;
-	heap_focal_t focal_list;
+	// define typedefs for the OPEN and FOCAL lists
+	typedef BucketQueue<SIPPNode, LLNode::open_priority, &SIPPNode::open_handle> open_list_t;
+	typedef BucketQueue<SIPPNode, LLNode::focal_priority, &SIPPNode::focal_handle> focal_list_t;
+	static thread_local open_list_t open_list; // shared by the solvers of a thread, like node_pool
+	static thread_local focal_list_t focal_list;
+	std::minstd_rand open_random_generator; // the tie breakers of this agent in the shared lists
+	std::minstd_rand focal_random_generator;
+	void prepareLists() // let the shared lists break ties by the generators of this agent
+	{
+		open_list.setRandomGenerator(open_random_generator);
+		focal_list.setRandomGenerator(focal_random_generator);
+	}
 
-	// define typedef for hash_map
-	typedef boost::unordered_map<SIPPNode*, list<SIPPNode*>, SIPPNode::NodeHasher, SIPPNode::eqnode> hashtable_t;
-    hashtable_t allNodes_table;
-    list<SIPPNode*> useless_nodes;
+	// define typedef for hash_map (duplicates -> the first one of their list)
+	typedef NodeTable<SIPPNode, SIPPNode::duplicate_key> hashtable_t;
+    static thread_local hashtable_t allNodes_table; // shared by the solvers of a thread, like node_pool
+    static thread_local NodePool<SIPPNode> node_pool; // shared by the solvers of a thread, as a search never runs inside another
     // Path findNoCollisionPath(const ConstraintTable& constraint_table);
 
     void updatePath(const LLNode* goal, std::vector<PathEntry> &path);
@@ -100,6 +89,7 @@ private:
 	inline void pushNodeToOpenAndFocal(SIPPNode* node);
     inline void pushNodeToFocal(SIPPNode* node);
     inline void eraseNodeFromLists(SIPPNode* node);
+    inline void insertNodeToTable(SIPPNode* node);
 	void updateFocalList();
 	void releaseNodes();
     bool dominanceCheck(SIPPNode* new_node);
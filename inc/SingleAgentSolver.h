@@ -1,6 +1,9 @@
 ﻿#pragma once
+#include <memory>
+#include <type_traits>
 #include "Instance.h"
 #include "ConstraintTable.h"
+#include "BucketQueue.h"
 
 class LLNode // low-level node
 {
@@ -14,44 +17,22 @@ public:
 	bool in_openlist = false;
 	bool wait_at_goal = false; // the action is to wait at the goal vertex or not. This is used for >lenghth constraints
     bool is_goal = false;
-	// the following is used to comapre nodes in the OPEN list
-	struct compare_node
+	// the priorities of nodes in the OPEN list: smaller f-vals first,
+	// and then smaller h-vals (closer to goal location); the remaining ties are broken randomly
+	struct open_priority
 	{
-		// returns true if n1 > n2 (note -- this gives us *min*-heap).
-		bool operator()(const LLNode* n1, const LLNode* n2) const
-		{
-            if (n1->g_val + n1->h_val == n2->g_val + n2->h_val)
-            {
-                if (n1->h_val == n2->h_val)
-                {
-                    return rand() % 2 == 0;   // break ties randomly
-                }
-                return n1->h_val >= n2->h_val;  // break ties towards smaller h_vals (closer to goal location)
-            }
-			return n1->g_val + n1->h_val >= n2->g_val + n2->h_val;
-		}
-	};  // used by OPEN (heap) to compare nodes (top of the heap has min f-val, and then highest g-val)
-
-		// the following is used to compare nodes in the FOCAL list
-	struct secondary_compare_node
+		static int primary(const LLNode* n) { return n->g_val + n->h_val; }
+		static int secondary(const LLNode* n) { return n->h_val; }
+		static int tertiary(const LLNode*) { return 0; }
+	};
+	// the priorities of nodes in the FOCAL list: fewer conflicts first, then smaller f-vals (prefer shorter solutions),
+	// and then smaller h-vals (closer to goal location); the remaining ties are broken randomly
+	struct focal_priority
 	{
-		bool operator()(const LLNode* n1, const LLNode* n2) const // returns true if n1 > n2
-		{
-			if (n1->num_of_conflicts == n2->num_of_conflicts)
-			{
-                if (n1->g_val + n1->h_val == n2->g_val + n2->h_val)
-                {
-                    if (n1->h_val == n2->h_val)
-                    {
-                        return rand() % 2 == 0;   // break ties randomly
-                    }
-                    return n1->h_val >= n2->h_val;  // break ties towards smaller h_vals (closer to goal location)
-                }
-                return n1->g_val+n1->h_val >= n2->g_val+n2->h_val;  // break ties towards smaller f_vals (prefer shorter solutions)
-			}
-			return n1->num_of_conflicts >= n2->num_of_conflicts;  // n1 > n2 if it has more conflicts
-		}
-	};  // used by FOCAL (heap) to compare nodes (top of the heap has min number-of-conflicts)
+		static int primary(const LLNode* n) { return n->num_of_conflicts; }
+		static int secondary(const LLNode* n) { return n->g_val + n->h_val; }
+		static int tertiary(const LLNode* n) { return n->h_val; }
+	};
 
 
 	LLNode() {}
@@ -77,6 +58,62 @@ public:
 
 std::ostream& operator<<(std::ostream& os, const LLNode& node);
 
+// The nodes of a low-level search. They are allocated in blocks and released all at once by clear(),
+// so a search does not call new and delete for every node it generates.
+// clear() keeps up to MAX_KEPT_BLOCKS blocks for the next search and frees the rest.
+// Nodes are never destructed, so the node type has to be trivially destructible.
+template<class Node>
+class NodePool
+{
+public:
+    template<class... Args>
+    Node* create(Args&&... args)
+    {
+        void* memory;
+        if (!free_nodes.empty()) // reuse a node released in this search
+        {
+            memory = free_nodes.back();
+            free_nodes.pop_back();
+        }
+        else
+        {
+            if (num_of_used_slots == blocks.size() * BLOCK_SIZE)
+                blocks.emplace_back(new Slot[BLOCK_SIZE]);
+            memory = &blocks[num_of_used_slots / BLOCK_SIZE][num_of_used_slots % BLOCK_SIZE];
+            num_of_used_slots++;
+        }
+        num_of_nodes++;
+        peak_num_of_nodes = max(peak_num_of_nodes, num_of_nodes);
+        return new (memory) Node(std::forward<Args>(args)...);
+    }
+    void release(Node* node) // the node must not be used afterward
+    {
+        free_nodes.push_back(node);
+        num_of_nodes--;
+    }
+    void clear() // release all nodes
+    {
+        if (blocks.size() > MAX_KEPT_BLOCKS) // only after an unusually large search
+            blocks.resize(MAX_KEPT_BLOCKS);
+        num_of_used_slots = 0;
+        free_nodes.clear();
+        num_of_nodes = 0;
+        peak_num_of_nodes = 0;
+    }
+    size_t getPeakNumOfNodes() const { return peak_num_of_nodes; } // since the last clear()
+
+private:
+    static_assert(std::is_trivially_destructible<Node>::value, "nodes are released without being destructed");
+    static const size_t BLOCK_SIZE = 1024; // nodes
+    static const size_t MAX_KEPT_BLOCKS = 64;
+    typedef typename std::aligned_storage<sizeof(Node), alignof(Node)>::type Slot;
+    vector< std::unique_ptr<Slot[]> > blocks;
+    size_t num_of_used_slots = 0;
+    vector<Node*> free_nodes;
+    size_t num_of_nodes = 0;
+    size_t peak_num_of_nodes = 0;
+};
+
 class SingleAgentSolver
 {
 public:
@@ -84,6 +121,7 @@ public:
     uint64_t accumulated_num_generated = 0;
     uint64_t accumulated_num_reopened = 0;
     uint64_t num_runs = 0;
+    uint64_t max_num_of_nodes = 0; // the peak number of nodes held in memory by any search
 
     int num_collisions = -1;
 	double runtime_build_CT = 0; // runtimr of building constraint table
@@ -91,7 +129,7 @@ public:
 
 	int start_location;
 	int goal_location;
-	vector<int> my_heuristic;  // this is the precomputed heuristic for this agent
+	const int* my_heuristic;  // this is the precomputed heuristic for this agent, shared with the agents with the same goal
 	int compute_heuristic(int from, int to) const  // compute admissible heuristic between two locations
 	{
 		return max(get_DH_heuristic(from, to), instance.getManhattanDistance(from, to));
@@ -104,24 +142,33 @@ public:
 		const vector<Path*>& paths, int agent, int lower_bound) = 0;
 	virtual pair<Path, int> findSuboptimalPath(const HLNode& node, const ConstraintTable& initial_constraints,
 		const vector<Path*>& paths, int agent, int lowerbound, double w) = 0;  // return the path and the lowerbound
-    virtual Path findPath(const ConstraintTable& constraint_table) = 0;  // return the path
+    // write the path into path (which is empty if there is no path), reusing the memory that path already has.
+    // The search prunes the nodes whose f-values exceed upper_bound, so path is also empty if every path costs more.
+    virtual void findPath(const ConstraintTable& constraint_table, Path& path, int upper_bound) = 0;
+    void findPath(const ConstraintTable& constraint_table, Path& path) { findPath(constraint_table, path, MAX_COST); }
+    Path findPath(const ConstraintTable& constraint_table)  // return the path
+    {
+        Path path;
+        findPath(constraint_table, path);
+        return path;
+    }
     void findMinimumSetofColldingTargets(vector<int>& goal_table,set<int>& A_target);
     virtual int getTravelTime(int start, int end, const ConstraintTable& constraint_table, int upper_bound) = 0;
 	virtual string getName() const = 0;
 
-	list<int> getNextLocations(int curr) const; // including itself and its neighbors
-	list<int> getNeighbors(int curr) const { return instance.getNeighbors(curr); }
+	LocationRange getNextLocations(int curr) const { return instance.getNextLocations(curr); } // including itself and its neighbors
+	LocationRange getNeighbors(int curr) const { return instance.getNeighbors(curr); }
     uint64_t getNumExpanded() const { return num_expanded; }
+    uint64_t getNumGenerated() const { return num_generated; }
+    uint64_t getPeakNumOfNodes() const { return peak_num_of_nodes; } // of the last search
 	// int getStartLocation() const {return instance.start_locations[agent]; }
 	// int getGoalLocation() const {return instance.goal_locations[agent]; }
 
 	SingleAgentSolver(const Instance& instance, int agent) :
 		instance(instance), //agent(agent), 
 		start_location(instance.start_locations[agent]),
-		goal_location(instance.goal_locations[agent])
-	{
-		compute_heuristics();
-	}
+		goal_location(instance.goal_locations[agent]),
+		my_heuristic(instance.getDistances(goal_location)) {}
 	virtual ~SingleAgentSolver()= default;
     void reset()
     {
@@ -140,11 +187,20 @@ protected:
     uint64_t num_expanded = 0;
     uint64_t num_generated = 0;
     uint64_t num_reopened = 0;
+    uint64_t peak_num_of_nodes = 0;
 	int min_f_val; // minimal f value in OPEN
 	// int lower_bound; // Threshold for FOCAL
 	double w = 1; // suboptimal bound
 
-	void compute_heuristics();
 	int get_DH_heuristic(int from, int to) const { return abs(my_heuristic[from] - my_heuristic[to]); }
+	// the seed of tie breaker i of the agent, mixed from the agent and the random seed of the run
+	// instead of drawn by rand(), so that constructing a solver does not shift the random numbers of the rest of the run
+	unsigned getTieBreakingSeed(int agent, int i) const
+	{
+		std::seed_seq seeds{instance.getRandomSeed(), agent, i};
+		unsigned seed;
+		seeds.generate(&seed, &seed + 1);
+		return seed;
+	}
 };
 
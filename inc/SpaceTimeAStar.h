@@ -1,48 +1,24 @@
 ﻿#pragma once
 #include "SingleAgentSolver.h"
+#include "NodeTable.h"
 
 
 class AStarNode: public LLNode
 {
 public:
-	// define a typedefs for handles to the heaps (allow up to quickly update a node in the heap)
-	typedef pairing_heap< AStarNode*, compare<LLNode::compare_node> >::handle_type open_handle_t;
-	typedef pairing_heap< AStarNode*, compare<LLNode::secondary_compare_node> >::handle_type focal_handle_t;
-	open_handle_t open_handle;
-	focal_handle_t focal_handle;
+	// the positions in the OPEN and FOCAL lists (allow us to quickly update a node in the lists)
+	BucketQueueHandle open_handle;
+	BucketQueueHandle focal_handle;
 
 	AStarNode() : LLNode() {}
     AStarNode(const AStarNode& other) : LLNode(other) {} // copy everything except for handles
 	AStarNode(int loc, int g_val, int h_val, LLNode* parent, int timestep, int num_of_conflicts) :
 		LLNode(loc, g_val, h_val, parent, timestep, num_of_conflicts) {}
 
-
-	~AStarNode() {}
-
-	// The following is used by for generating the hash value of a nodes
-	struct NodeHasher
+	// two nodes are duplicates if they agree on the location, the timestep, wait_at_goal and is_goal
+	struct duplicate_key
 	{
-		size_t operator()(const AStarNode* n) const
-		{
-			size_t loc_hash = std::hash<int>()(n->location);
-			size_t timestep_hash = std::hash<int>()(n->timestep);
-			return (loc_hash ^ (timestep_hash << 1));
-		}
-	};
-
-	// The following is used for checking whether two nodes are equal
-	// we say that two nodes, s1 and s2, are equal if
-	// both are non-NULL and agree on the id and timestep
-	struct eqnode
-	{
-		bool operator()(const AStarNode* s1, const AStarNode* s2) const
-		{
-			return (s1 == s2) || (s1 && s2 &&
-                        s1->location == s2->location &&
-                        s1->timestep == s2->timestep &&
-						s1->wait_at_goal == s2->wait_at_goal &&
-						s1->is_goal == s2->is_goal);
-		}
+		static int time(const AStarNode* n) { return n->timestep; }
 	};
 };
 
@@ -64,7 +40,8 @@ public:
     // find path by time-space A* search
     // Returns a path that satisfies the constraint_table while
     // minimizing the number of conflicts with constraint_table, breaking ties by the path length.
-    Path findPath(const ConstraintTable& constraint_table);
+    using SingleAgentSolver::findPath;
+    void findPath(const ConstraintTable& constraint_table, Path& path, int upper_bound);
 
 	pair<Path, int> findSuboptimalPath(const HLNode& node, const ConstraintTable& initial_constraints,
 		const vector<Path*>& paths, int agent, int lowerbound, double w);  // return the path and the lowerbound
@@ -75,18 +52,30 @@ public:
 	string getName() const { return "AStar"; }
 
 	SpaceTimeAStar(const Instance& instance, int agent):
-		SingleAgentSolver(instance, agent) {}
+		SingleAgentSolver(instance, agent)
+	{
+		open_random_generator.seed(getTieBreakingSeed(agent, 0)); // break ties in the same way in every run with the same seed
+		focal_random_generator.seed(getTieBreakingSeed(agent, 1));
+	}
 
 private:
-	// define typedefs and handles for heap
-	typedef pairing_heap< AStarNode*, compare<AStarNode::compare_node> > heap_open_t;
-	typedef pairing_heap< AStarNode*, compare<AStarNode::secondary_compare_node> > heap_focal_t;
-	heap_open_t open_list;
-	heap_focal_t focal_list;
+	// define typedefs for the OPEN and FOCAL lists
+	typedef BucketQueue<AStarNode, LLNode::open_priority, &AStarNode::open_handle> open_list_t;
+	typedef BucketQueue<AStarNode, LLNode::focal_priority, &AStarNode::focal_handle> focal_list_t;
+	static thread_local open_list_t open_list; // shared by the solvers of a thread, like node_pool
+	static thread_local focal_list_t focal_list;
+	std::minstd_rand open_random_generator; // the tie breakers of this agent in the shared lists
+	std::minstd_rand focal_random_generator;
+	void prepareLists() // let the shared lists break ties by the generators of this agent
+	{
+		open_list.setRandomGenerator(open_random_generator);
+		focal_list.setRandomGenerator(focal_random_generator);
+	}
 
 	// define typedef for hash_map
-	typedef unordered_set<AStarNode*, AStarNode::NodeHasher, AStarNode::eqnode> hashtable_t;
-	hashtable_t allNodes_table;
+	typedef NodeTable<AStarNode, AStarNode::duplicate_key> hashtable_t;
+	static thread_local hashtable_t allNodes_table; // shared by the solvers of a thread, like node_pool
+	static thread_local NodePool<AStarNode> node_pool; // shared by the solvers of a thread, as a search never runs inside another
 
 	// Updates the path datamember
 	void updatePath(const LLNode* goal, vector<PathEntry> &path);
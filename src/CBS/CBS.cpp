@@ -9,8 +9,6 @@
 // takes the paths_found_initially and UPDATE all (constrained) paths found for agents from curr to start
 void CBS::updatePaths(CBSNode* curr)
 {
-	for (int i = 0; i < num_of_agents; i++)
-		paths[i] = &paths_found_initially[i];
 	vector<bool> updated(num_of_agents, false);  // initialized for false
 
 	while (curr != nullptr)
@@ -19,12 +17,17 @@ void CBS::updatePaths(CBSNode* curr)
 		{
 			if (!updated[path.first])
 			{
-				paths[path.first] = &(path.second);
+				setPath(path.first, &(path.second));
 				updated[path.first] = true;
 			}
 		}
 		curr = curr->parent;
 	}
+	for (int i = 0; i < num_of_agents; i++)
+	{
+		if (!updated[i])
+			setPath(i, &paths_found_initially[i]);
+	}
 }
 
 
@@ -421,6 +424,47 @@ void CBS::removeLowPriorityConflicts(list<shared_ptr<Conflict>>& conflicts) cons
 	}
 }
 
+void CBS::updateCAT(int agent)
+{
+	clock_t t = clock();
+	if (paths_in_CAT.empty())
+	{
+		path_table_for_CAT = PathTableWC(search_engines[0]->instance.map_size, num_of_agents);
+		paths_in_CAT.resize(num_of_agents, false);
+		copies_in_CAT.resize(num_of_agents);
+		changed_in_CAT.resize(num_of_agents, false);
+		for (int i = 0; i < num_of_agents; i++)
+			markChangedInCAT(i);
+		agent_out_of_CAT = -1;
+	}
+	if (agent != agent_out_of_CAT) // put the agent of the last search back, and take this one out
+	{
+		if (agent_out_of_CAT >= 0)
+			markChangedInCAT(agent_out_of_CAT);
+		markChangedInCAT(agent);
+		agent_out_of_CAT = agent;
+	}
+	for (int i : agents_changed_in_CAT)
+	{
+		changed_in_CAT[i] = false;
+		if (paths_in_CAT[i])
+			path_table_for_CAT.deletePath(i);
+		paths_in_CAT[i] = (i != agent and paths[i] != nullptr);
+		if (paths_in_CAT[i])
+		{
+			copies_in_CAT[i] = *paths[i];
+			path_table_for_CAT.insertPath(i, copies_in_CAT[i]);
+		}
+	}
+	agents_changed_in_CAT.clear();
+	for (int i = 0; i < num_of_agents; i++) // the CAT is consistent with paths (checked in debug builds only)
+		assert(paths_in_CAT[i] == (i != agent and paths[i] != nullptr) and
+		       (!paths_in_CAT[i] or isSamePath(*paths[i], copies_in_CAT[i])));
+	// the low-level search inserts paths into its CAT only if it is not given one
+	initial_constraints[agent].path_table_for_CAT = &path_table_for_CAT;
+	runtime_build_CAT += (double)(clock() - t) / CLOCKS_PER_SEC;
+}
+
 bool CBS::findPathForSingleAgent(CBSNode*  node, int ag, int lowerbound)
 {
 	clock_t t = clock();
@@ -428,7 +472,9 @@ bool CBS::findPathForSingleAgent(CBSNode*  node, int ag, int lowerbound)
 	// CAT cat(node->makespan + 1);  // initialized to false
 	// updateReservationTable(cat, ag, *node);
 	// find a path
+	updateCAT(ag);
 	Path new_path = search_engines[ag]->findOptimalPath(*node, initial_constraints[ag], paths, ag, lowerbound);
+	initial_constraints[ag].path_table_for_CAT = nullptr;
 	runtime_build_CT += search_engines[ag]->runtime_build_CT;
 	runtime_build_CAT += search_engines[ag]->runtime_build_CAT;
 	runtime_path_finding += (double)(clock() - t) / CLOCKS_PER_SEC;
@@ -437,7 +483,7 @@ bool CBS::findPathForSingleAgent(CBSNode*  node, int ag, int lowerbound)
 		assert(!isSamePath(*paths[ag], new_path));
 		node->paths.emplace_back(ag, new_path);
 		node->g_val = node->g_val - (int)paths[ag]->size() + (int)new_path.size();
-		paths[ag] = &node->paths.back().second;
+		setPath(ag, &node->paths.back().second);
 		node->makespan = max(node->makespan, new_path.size() - 1);
 		return true;
 	}
@@ -1247,10 +1293,11 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 			for (int i = 0; i < 2; i++)
 			{
 				if (i > 0)
-					paths = copy;
+					setPaths(copy);
 				solved[i] = generateChild(child[i], curr);
 				if (!solved[i])
 				{
+					markChangedInCAT(*child[i]);
 					delete (child[i]);
 					continue;
 				}
@@ -1273,6 +1320,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 							{
 								p->second = path.second;
 								paths[p->first] = &p->second;
+								markChangedInCAT(p->first); // rewritten in place
 								break;
 							}
 							++p;
@@ -1280,7 +1328,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 						if (p == curr->paths.end())
 						{
 							curr->paths.emplace_back(path);
-							paths[path.first] = &curr->paths.back().second;
+							setPath(path.first, &curr->paths.back().second);
 						}
 					}
 					if (screen > 1)
@@ -1294,6 +1342,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 			{
 				for (auto & i : child)
 				{
+					markChangedInCAT(*i);
 					delete i;
 					i = nullptr;
 				}
@@ -1375,8 +1424,8 @@ bool CBS::terminate(HLNode* curr)
 			printResults();
 		return true;
 	}
-	if (runtime > time_limit || num_HL_expanded > node_limit)
-	{   // time/node out
+	if (runtime > time_limit || num_HL_expanded > node_limit || stopped())
+	{   // time/node out, or stopped by another thread or the deadline
 		solution_cost = -1;
 		solution_found = false;
         if (screen > 0) // 1 or 2
@@ -1546,7 +1595,9 @@ bool CBS::generateRoot()
 		{
 			//CAT cat(dummy_start->makespan + 1);  // initialized to false
 			//updateReservationTable(cat, i, *dummy_start);
+			updateCAT(i);
 			paths_found_initially[i] = search_engines[i]->findOptimalPath(*root, initial_constraints[i], paths, i, 0);
+			initial_constraints[i].path_table_for_CAT = nullptr;
 			if (paths_found_initially[i].empty())
 			{
 				cout << "No path exists for agent " << i << endl;
@@ -1554,13 +1605,13 @@ bool CBS::generateRoot()
 				return false;
 			}
             runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
-            if (runtime > time_limit)
+            if (runtime > time_limit || stopped())
             {
                 cout << "Time out when generating the root CT node" << endl;
                 delete root;
                 return false;
             }
-			paths[i] = &paths_found_initially[i];
+			setPath(i, &paths_found_initially[i]);
 			root->makespan = max(root->makespan, paths_found_initially[i].size() - 1);
 			root->g_val += (int)paths_found_initially[i].size() - 1;
 		}
@@ -1569,7 +1620,7 @@ bool CBS::generateRoot()
 	{
 		for (int i = 0; i < num_of_agents; i++)
 		{
-			paths[i] = &paths_found_initially[i];
+			setPath(i, &paths_found_initially[i]);
 			root->makespan = max(root->makespan, paths_found_initially[i].size() - 1);
 			root->g_val += (int) paths_found_initially[i].size() - 1;
 		}
@@ -1700,6 +1751,11 @@ void CBS::clear()
 	releaseNodes();
 	paths.clear();
 	paths_found_initially.clear();
+	path_table_for_CAT.clear();
+	paths_in_CAT.clear();
+	copies_in_CAT.clear();
+	agents_changed_in_CAT.clear();
+	changed_in_CAT.clear();
 	dummy_start = nullptr;
 	goal_node = nullptr;
 	solution_found = false;
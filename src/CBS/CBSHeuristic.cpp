@@ -510,7 +510,7 @@ bool CBSHeuristic::buildDependenceGraph(CBSNode& node, vector<int>& CG, int& num
             CG[idx] = dependent(a1, a2, node)? 1 : 0;
             CG[a2 * num_of_agents + a1] = CG[idx];
             lookupTable[a1][a2][HTableEntry(a1, a2, &node)] = make_tuple(CG[idx], 1, 0);
-            if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+            if ((double)(clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
             {
                 runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
                 return false;
@@ -571,7 +571,7 @@ bool CBSHeuristic::buildWeightedDependencyGraph(CBSNode& node, vector<int>& CG)
 				CG[a2 * num_of_agents + a1] = 0;
 			}
 		}
-		if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+		if ((double)(clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
 		{
 			runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
 			return false;
@@ -623,7 +623,7 @@ bool CBSHeuristic::buildWeightedDependencyGraph(ECBSNode& node, const vector<int
 		{
 			auto rst = solve2Agents(a1, a2, node);
             lookupTable[a1][a2][HTableEntry(a1, a2, &node)] = rst;
-            if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+            if ((double)(clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
             {
                 runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
                 return false;
@@ -675,7 +675,7 @@ bool CBSHeuristic::buildWeightedDependencyGraph(ECBSNode& node, const vector<int
         {
             auto rst = solve2Agents(a1, a2, node);
             lookupTable[a1][a2][HTableEntry(a1, a2, &node)] = rst;
-            if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+            if ((double)(clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
             {
                 runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
                 return false;
@@ -787,7 +787,9 @@ tuple<int, int, int> CBSHeuristic::solve2Agents(int a1, int a2, const ECBSNode&
 		sub_instances.emplace_back(a1, a2, &node, cbs.num_HL_expanded, (int)cbs.num_HL_expanded);
 	}
 
-	if (cbs.runtime >= time_limit - runtime || cbs.num_HL_expanded > node_limit) // time out or node out
+	if (cbs.dummy_start == nullptr && cbs.runtime >= time_limit - runtime) // time out before generating the root
+		return make_tuple(0, cbs.getInitialPathLength(0), cbs.getInitialPathLength(1)); // the caller runs out of time too
+	else if (cbs.runtime >= time_limit - runtime || cbs.num_HL_expanded > node_limit) // time out or node out
 		return make_tuple(cbs.getLowerBound() - cbs.dummy_start->g_val,
 		        cbs.getInitialPathLength(0), cbs.getInitialPathLength(1)); // using lowerbound to approximate
 	else if (cbs.solution_cost  < 0) // no solution
@@ -310,9 +310,7 @@ int CorridorReasoning::getBypassLengthByAStar(int start, int end, pair<int, int>
 			length = curr->g_val;
 			break;
 		}
-		list<int> next_locations = instance.getNeighbors(curr->location);
-		next_locations.emplace_back(curr->location);
-		for (int next_location : next_locations)
+		for (int next_location : instance.getNextLocations(curr->location))
 		{
 			int next_timestep = curr->timestep + 1;
 			int next_g_val = curr->g_val + 1;
@@ -77,12 +77,13 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 				{
 					if (i > 0)
 					{
-						paths = path_copy;
+						setPaths(path_copy);
 						min_f_vals = fmin_copy;
 					}
 					solved[i] = generateChild(child[i], curr);
 					if (!solved[i])
 					{
+						markChangedInCAT(*child[i]);
 						delete (child[i]);
 						continue;
 					}
@@ -119,6 +120,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 				{
 					for (auto & i : child)
 					{
+						markChangedInCAT(*i);
 						delete i;
 					}
                     classifyConflicts(*curr); // classify the new-detected conflicts
@@ -156,12 +158,13 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 			{
 				if (i > 0)
 				{
-					paths = path_copy;
+					setPaths(path_copy);
 					min_f_vals = fmin_copy;
 				}
 				solved[i] = generateChild(child[i], curr);
 				if (!solved[i])
 				{
+					markChangedInCAT(*child[i]);
 					delete (child[i]);
 					continue;
 				}
@@ -226,6 +229,7 @@ void ECBS::adoptBypass(ECBSNode* curr, ECBSNode* child, const vector<int>& fmin_
 			{
 				p->second.first = path.second.first;
 				paths[p->first] = &p->second.first;
+				markChangedInCAT(p->first); // rewritten in place
                 min_f_vals[p->first] = p->second.second;
 				break;
 			}
@@ -235,7 +239,7 @@ void ECBS::adoptBypass(ECBSNode* curr, ECBSNode* child, const vector<int>& fmin_
 		{
 			curr->paths.emplace_back(path);
 			curr->paths.back().second.second = fmin_copy[path.first];
-			paths[path.first] = &curr->paths.back().second.first;
+			setPath(path.first, &curr->paths.back().second.first);
 			min_f_vals[path.first] = fmin_copy[path.first];
 		}
 	}
@@ -245,11 +249,6 @@ void ECBS::adoptBypass(ECBSNode* curr, ECBSNode* child, const vector<int>& fmin_
 // also, do the same for ll_min_f_vals and paths_costs (since its already "on the way").
 void ECBS::updatePaths(ECBSNode* curr)
 {
-	for (int i = 0; i < num_of_agents; i++)
-	{
-		paths[i] = &paths_found_initially[i].first;
-		min_f_vals[i] = paths_found_initially[i].second;
-	}
 	vector<bool> updated(num_of_agents, false);  // initialized for false
 
 	while (curr != nullptr)
@@ -259,13 +258,21 @@ void ECBS::updatePaths(ECBSNode* curr)
 			int agent = path.first;
 			if (!updated[agent])
 			{
-				paths[agent] = &path.second.first;
+				setPath(agent, &path.second.first);
 				min_f_vals[agent] = path.second.second;
 				updated[agent] = true;
 			}
 		}
 		curr = curr->parent;
 	}
+	for (int i = 0; i < num_of_agents; i++)
+	{
+		if (!updated[i])
+		{
+			setPath(i, &paths_found_initially[i].first);
+			min_f_vals[i] = paths_found_initially[i].second;
+		}
+	}
 }
 
 
@@ -287,7 +294,9 @@ bool ECBS::generateRoot()
 
 	for (auto i : agents)
 	{
+		updateCAT(i);
 		paths_found_initially[i] = search_engines[i]->findSuboptimalPath(*root, initial_constraints[i], paths, i, 0, suboptimality);
+		initial_constraints[i].path_table_for_CAT = nullptr;
 		if (paths_found_initially[i].first.empty())
 		{
 			cerr << "No path exists for agent " << i << endl;
@@ -295,13 +304,13 @@ bool ECBS::generateRoot()
 			return false;
 		}
         runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
-		if (runtime > time_limit)
+		if (runtime > time_limit || stopped())
         {
 		    cout << "Time out when generating the root CT node" << endl;
             delete root;
 		    return false;
         }
-		paths[i] = &paths_found_initially[i].first;
+		setPath(i, &paths_found_initially[i].first);
 		min_f_vals[i] = paths_found_initially[i].second;
 		root->makespan = max(root->makespan, paths[i]->size() - 1);
 		root->g_val += min_f_vals[i];
@@ -354,7 +363,9 @@ bool ECBS::generateChild(ECBSNode*  node, ECBSNode* parent)
 bool ECBS::findPathForSingleAgent(ECBSNode*  node, int ag)
 {
 	clock_t t = clock();
+	updateCAT(ag);
 	auto new_path = search_engines[ag]->findSuboptimalPath(*node, initial_constraints[ag], paths, ag, min_f_vals[ag], suboptimality);
+	initial_constraints[ag].path_table_for_CAT = nullptr;
 	runtime_build_CT += search_engines[ag]->runtime_build_CT;
 	runtime_build_CAT += search_engines[ag]->runtime_build_CAT;
 	runtime_path_finding += (double)(clock() - t) / CLOCKS_PER_SEC;
@@ -364,7 +375,7 @@ bool ECBS::findPathForSingleAgent(ECBSNode*  node, int ag)
 	node->paths.emplace_back(ag, new_path);
 	node->g_val = node->g_val - min_f_vals[ag] + new_path.second;
 	node->sum_of_costs = node->sum_of_costs - (int) paths[ag]->size() + (int) new_path.first.size();
-	paths[ag] = &node->paths.back().second.first;
+	setPath(ag, &node->paths.back().second.first);
 	min_f_vals[ag] = new_path.second;
 	node->makespan = max(node->makespan, new_path.first.size() - 1);
 	return true;
@@ -793,6 +804,11 @@ void ECBS::clear()
     releaseNodes();
     paths.clear();
     paths_found_initially.clear();
+    path_table_for_CAT.clear();
+    paths_in_CAT.clear();
+    copies_in_CAT.clear();
+    agents_changed_in_CAT.clear();
+    changed_in_CAT.clear();
     min_f_vals.clear();
     dummy_start = nullptr;
     goal_node = nullptr;
@@ -174,7 +174,7 @@ bool MDD::buildMDD(const ConstraintTable& ct,
 		}
 		// We want (g + 1)+h <= f = numOfLevels - 1, so h <= numOfLevels - g - 2. -1 because it's the bound of the children.
 		int heuristicBound = num_of_levels - curr->level - 2;
-		list<int> next_locations = solver->getNextLocations(curr->location);
+		auto next_locations = solver->getNextLocations(curr->location);
 		for (int next_location : next_locations) // Try every possible move. We only add backward edges in this step.
 		{
 			if (solver->my_heuristic[next_location] <= heuristicBound &&
@@ -0,0 +1,140 @@
+#include "ConcurrentPathTable.h"
+
+ConcurrentPathTable::ConcurrentPathTable(int map_size) : map_size(map_size), concurrent_makespan(0)
+{
+    buckets = new std::atomic<std::atomic<int>*>[map_size * NUM_BUCKETS];
+    lengths = new std::atomic<int>[map_size];
+    goal_times = new std::atomic<int>[map_size];
+    for (int i = 0; i < map_size * NUM_BUCKETS; i++)
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+    for (int i = 0; i < map_size; i++)
+    {
+        lengths[i].store(0, std::memory_order_relaxed);
+        goal_times[i].store(MAX_TIMESTEP, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentPathTable::~ConcurrentPathTable()
+{
+    clearBuckets();
+    delete[] buckets;
+    delete[] lengths;
+    delete[] goal_times;
+}
+
+void ConcurrentPathTable::clearBuckets()
+{
+    for (int i = 0; i < map_size * NUM_BUCKETS; i++)
+    {
+        delete[] buckets[i].load(std::memory_order_relaxed);
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// this must not run concurrently with any readers
+void ConcurrentPathTable::reset()
+{
+    clearBuckets();
+    for (int i = 0; i < map_size; i++)
+    {
+        lengths[i].store(0, std::memory_order_relaxed);
+        goal_times[i].store(MAX_TIMESTEP, std::memory_order_relaxed);
+    }
+    goal_time_counter.clear();
+    concurrent_makespan.store(0, std::memory_order_release);
+}
+
+std::atomic<int>& ConcurrentPathTable::getCell(int location, int timestep)
+{
+    int bucket, offset;
+    getBucket(timestep, bucket, offset);
+    assert(bucket < NUM_BUCKETS);
+    auto& slot = buckets[location * NUM_BUCKETS + bucket];
+    auto* cells = slot.load(std::memory_order_acquire);
+    if (cells == nullptr)
+    {
+        int size = FIRST_BUCKET_SIZE << bucket;
+        auto* new_cells = new std::atomic<int>[size];
+        for (int i = 0; i < size; i++)
+            new_cells[i].store(NO_AGENT, std::memory_order_relaxed);
+        if (slot.compare_exchange_strong(cells, new_cells, std::memory_order_acq_rel))
+            cells = new_cells;
+        else // another thread has allocated the bucket
+            delete[] new_cells;
+    }
+    return cells[offset];
+}
+
+void ConcurrentPathTable::insertPath(int agent_id, const Path& path)
+{
+    if (path.empty())
+        return;
+    for (int t = 0; t < (int)path.size(); t++)
+    {
+        int location = path[t].location;
+        int expected = NO_AGENT;
+        if (!getCell(location, t).compare_exchange_strong(expected, agent_id, std::memory_order_acq_rel))
+        {
+            cerr << "Cell (" << location << "," << t << ") is already occupied by agent " << expected << endl;
+            exit(-1);
+        }
+        int length = lengths[location].load(std::memory_order_relaxed);
+        while (length <= t and
+               !lengths[location].compare_exchange_weak(length, t + 1, std::memory_order_acq_rel)) {}
+    }
+    assert(goal_times[path.back().location].load() == MAX_TIMESTEP);
+    goal_times[path.back().location].store((int) path.size() - 1, std::memory_order_release);
+    goal_time_counter.insert((int) path.size() - 1);
+    concurrent_makespan.store(goal_time_counter.getMakespan(), std::memory_order_release);
+}
+
+void ConcurrentPathTable::deletePath(int agent_id, const Path& path)
+{
+    if (path.empty())
+        return;
+    for (int t = 0; t < (int)path.size(); t++)
+    {
+        int expected = agent_id;
+        if (!getCell(path[t].location, t).compare_exchange_strong(expected, NO_AGENT, std::memory_order_acq_rel))
+        {
+            cerr << "Cell (" << path[t].location << "," << t << ") is occupied by agent " << expected
+                 << " instead of agent " << agent_id << endl;
+            exit(-1);
+        }
+    }
+    goal_times[path.back().location].store(MAX_TIMESTEP, std::memory_order_release);
+    goal_time_counter.erase((int) path.size() - 1);
+    concurrent_makespan.store(goal_time_counter.getMakespan(), std::memory_order_release);
+}
+
+bool ConcurrentPathTable::constrained(int from, int to, int to_time) const
+{
+    return constrainedByCells(*this, from, to, to_time);
+}
+
+int ConcurrentPathTable::getHoldingTime(int location, int earliest_timestep) const
+{
+    return getHoldingTimeByCells(*this, location, earliest_timestep);
+}
+
+bool PathTableView::constrained(int from, int to, int to_time) const
+{
+    return constrainedByCells(*this, from, to, to_time);
+}
+
+int PathTableView::getHoldingTime(int location, int earliest_timestep) const
+{
+    return getHoldingTimeByCells(*this, location, earliest_timestep);
+}
+
+int PathTableView::getGoalTime(int location) const
+{
+    int goal_time = path_table.getGoalTime(location);
+    if (goal_time < MAX_TIMESTEP)
+    {
+        int agent = path_table.getAgent(location, goal_time); // the agent whose goal is the location
+        if (agent != NO_AGENT and ignored[agent])
+            return MAX_TIMESTEP;
+    }
+    return goal_time;
+}
@@ -1,12 +1,13 @@
+#include <algorithm>
 #include "ConstraintTable.h"
 
 int ConstraintTable::getMaxTimestep() const // everything is static after the max timestep
 {
     int rst = max(max(ct_max_timestep, cat_max_timestep), length_min);
     if (path_table_for_CT != nullptr)
-        rst = max(rst, path_table_for_CT->makespan);
+        rst = max(rst, path_table_for_CT->getMakespan());
     if (path_table_for_CAT != nullptr)
-        rst = max(rst, path_table_for_CAT->makespan);
+        rst = max(rst, path_table_for_CAT->getMakespan());
     if (length_max < MAX_TIMESTEP)
         rst = max(rst, length_max);
     if (!landmarks.empty())
@@ -20,10 +21,11 @@ int ConstraintTable::getLastCollisionTimestep(int location) const
         rst = path_table_for_CAT->getLastCollisionTimestep(location);
     if (!cat.empty())
     {
-        for (auto t = cat[location].size() - 1; t > rst; t--)
+        const auto& bits = cat[location];
+        for (int word = (int)bits.size() - 1; word >= 0 and word * 64 + 63 > rst; word--)
         {
-            if (cat[location][t])
-                return t;
+            if (bits[word] != 0) // return its highest bit
+                return max(rst, word * 64 + 63 - __builtin_clzll(bits[word]));
         }
     }
     return rst;
@@ -35,7 +37,11 @@ void ConstraintTable::insert2CT(size_t from, size_t to, int t_min, int t_max)
 void ConstraintTable::insert2CT(size_t loc, int t_min, int t_max)
 {
 	assert(loc >= 0);
-	ct[loc].emplace_back(t_min, t_max);
+	if (ct == nullptr)
+	    ct = make_shared<CT>();
+	else if (ct.use_count() > 1) // copy on write
+	    ct = make_shared<CT>(*ct);
+	ct->push_back(CTEntry{loc, t_min, t_max}); // sorted at the next query
 	if (t_max < MAX_TIMESTEP && t_max > ct_max_timestep)
 	{
         ct_max_timestep = t_max;
@@ -192,9 +198,10 @@ void ConstraintTable::insert2CAT(const Path& path)
     for (auto timestep = (int)path.size() - 1; timestep >= 0; timestep--)
     {
         int loc = path[timestep].location;
-        if (cat[loc].size() <= timestep)
-            cat[loc].resize(timestep + 1, false);
-        cat[loc][timestep] = true;
+        size_t word = timestep / 64;
+        if (cat[loc].size() <= word)
+            cat[loc].resize(word + 1, 0);
+        cat[loc][word] |= (uint64_t)1 << (timestep % 64);
     }
     cat_max_timestep = max(cat_max_timestep, (int)path.size() - 1);
 }
@@ -247,18 +254,36 @@ bool ConstraintTable::constrained(size_t loc, int t) const
 			return true;  // violate the positive vertex constraint
 	}	
 
-	const auto& it = ct.find(loc);
-	if (it == ct.end())
+	auto range = getConstraints(loc);
+	for (auto it = range.first; it != range.second; ++it)
 	{
-		return false;
-	}
-	for (const auto& constraint: it->second)
-	{
-		if (constraint.first <= t && t < constraint.second)
+		if (it->t_min <= t && t < it->t_max)
 			return true;
 	}
 	return false;
 }
+void ConstraintTable::sortCT() const
+{
+    if (ct == nullptr or ct_num_of_sorted == ct->size())
+        return;
+    auto by_location = [](const CTEntry& a, const CTEntry& b) { return a.location < b.location; };
+    auto middle = ct->begin() + ct_num_of_sorted;
+    std::stable_sort(middle, ct->end(), by_location);
+    std::inplace_merge(ct->begin(), middle, ct->end(), by_location);
+    ct_num_of_sorted = ct->size();
+}
+pair<ConstraintTable::CT::const_iterator, ConstraintTable::CT::const_iterator> ConstraintTable::getConstraints(size_t loc) const
+{
+    if (ct == nullptr)
+        return {CT::const_iterator(), CT::const_iterator()};
+    sortCT();
+    auto first = std::lower_bound(ct->cbegin(), ct->cend(), loc,
+            [](const CTEntry& entry, size_t location) { return entry.location < location; });
+    auto last = first;
+    while (last != ct->cend() and last->location == loc)
+        ++last;
+    return {first, last};
+}
 bool ConstraintTable::constrained(size_t curr_loc, size_t next_loc, int next_t) const
 {
     return (path_table_for_CT != nullptr and path_table_for_CT->constrained(curr_loc, next_loc, next_t)) or
@@ -271,7 +296,9 @@ void ConstraintTable::copy(const ConstraintTable& other)
 	length_max = other.length_max;
 	num_col = other.num_col;
 	map_size = other.map_size;
+	other.sortCT(); // only share sorted arrays
 	ct = other.ct;
+	ct_num_of_sorted = other.ct_num_of_sorted;
 	ct_max_timestep = other.ct_max_timestep;
 	cat = other.cat;
 	cat_goals = other.cat_goals;
@@ -290,10 +317,9 @@ int ConstraintTable::getNumOfConflictsForStep(size_t curr_id, size_t next_id, in
 
     if (!cat.empty())
     {
-        if (cat[next_id].size() > next_timestep and cat[next_id][next_timestep])
+        if (isInCAT(next_id, next_timestep))
             rst++;
-        if (curr_id != next_id and cat[next_id].size() >= next_timestep and cat[curr_id].size() > next_timestep and
-                cat[next_id][next_timestep - 1]and cat[curr_id][next_timestep])
+        if (curr_id != next_id and isInCAT(next_id, next_timestep - 1) and isInCAT(curr_id, next_timestep))
             rst++;
         if (cat_goals[next_id] < next_timestep)
             rst++;
@@ -306,10 +332,9 @@ bool ConstraintTable::hasConflictForStep(size_t curr_id, size_t next_id, int nex
         return true;
     if (!cat.empty())
     {
-        if (cat[next_id].size() > next_timestep and cat[next_id][next_timestep])
+        if (isInCAT(next_id, next_timestep))
             return true;
-        if (curr_id != next_id and cat[next_id].size() >= next_timestep and cat[curr_id].size() > next_timestep and
-            cat[next_id][next_timestep - 1]and cat[curr_id][next_timestep])
+        if (curr_id != next_id and isInCAT(next_id, next_timestep - 1) and isInCAT(curr_id, next_timestep))
             return true;
         if (cat_goals[next_id] < next_timestep)
             return true;
@@ -321,9 +346,8 @@ bool ConstraintTable::hasEdgeConflict(size_t curr_id, size_t next_id, int next_t
     assert(curr_id != next_id);
     if (path_table_for_CAT != nullptr and path_table_for_CAT->hasEdgeCollisions(curr_id, next_id, next_timestep))
         return true;
-    return !cat.empty() and curr_id != next_id and cat[next_id].size() >= next_timestep and
-            cat[curr_id].size() > next_timestep and
-            cat[next_id][next_timestep - 1] and cat[curr_id][next_timestep];
+    return !cat.empty() and curr_id != next_id and
+            isInCAT(next_id, next_timestep - 1) and isInCAT(curr_id, next_timestep);
 }
 int ConstraintTable::getFutureNumOfCollisions(int loc, int t) const
 {
@@ -331,12 +355,18 @@ int ConstraintTable::getFutureNumOfCollisions(int loc, int t) const
     if (path_table_for_CAT != nullptr)
         rst = path_table_for_CAT->getFutureNumOfCollisions(loc, t);
     if (!cat.empty())
-    {
-        for (auto timestep = t + 1; timestep < cat[loc].size(); timestep++)
-        {
-            rst += (int)cat[loc][timestep];
-        }
-    }
+        rst += getNumOfCATTimesteps(loc, t + 1);
+    return rst;
+}
+int ConstraintTable::getNumOfCATTimesteps(size_t loc, int t_min) const
+{
+    const auto& bits = cat[loc];
+    size_t word = t_min / 64;
+    if (word >= bits.size())
+        return 0;
+    int rst = __builtin_popcountll(bits[word] >> (t_min % 64));
+    for (word++; word < bits.size(); word++)
+        rst += __builtin_popcountll(bits[word]);
     return rst;
 }
 
@@ -348,12 +378,9 @@ int ConstraintTable::getHoldingTime(int location, int earliest_timestep) const
     if (path_table_for_CT!= nullptr)
         rst = path_table_for_CT->getHoldingTime(location, earliest_timestep);
     // CT
-	auto it = ct.find(location);
-	if (it != ct.end())
-	{
-		for (auto time_range : it->second)
-			rst = max(rst, time_range.second);
-	}
+	auto range = getConstraints(location);
+	for (auto it = range.first; it != range.second; ++it)
+		rst = max(rst, it->t_max);
 	// Landmark
 	for (auto landmark : landmarks)
 	{
@@ -1,15 +1,25 @@
 #include "InitLNS.h"
 #include <queue>
 #include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "GCBS.h"
 #include "PBS.h"
 
 InitLNS::InitLNS(const Instance& instance, vector<Agent>& agents, double time_limit,
-         const string & replan_algo_name, const string & init_destory_name, int neighbor_size, int screen) :
+         const string & replan_algo_name, const string & init_destory_name, int neighbor_size, int screen,
+         int num_of_threads) :
          BasicLNS(instance, time_limit, neighbor_size, screen), agents(agents), replan_algo_name(replan_algo_name),
-         path_table(instance.map_size, agents.size()), collision_graph(agents.size()), goal_table(instance.map_size, -1)
+         num_of_threads(num_of_threads), path_table(instance.map_size, agents.size()),
+         collision_graph(agents.size()), goal_table(instance.map_size, -1)
  {
      replan_time_limit = time_limit;
+     if (num_of_threads > 1 and replan_algo_name != "PP")
+     {
+         cerr << "Parallel InitLNS only supports PP as the replanning algorithm. " << endl;
+         exit(-1);
+     }
      if (init_destory_name == "Adaptive")
      {
          ALNS = true;
@@ -56,132 +66,140 @@ bool InitLNS::run()
     }
 
     vector<Path*> paths(agents.size());
-    for (auto i = 0; i < agents.size(); i++)
+    for (int i = 0; i < (int)agents.size(); i++)
         paths[i] = &agents[i].path;
+    if (num_of_threads > 1)
+        runInParallel(); // this uses up the time limit or removes all collisions, so the loop below is skipped
     while (runtime < time_limit and num_of_colliding_pairs > 0)
     {
         assert(instance.validateSolution(paths, sum_of_costs, num_of_colliding_pairs));
-        if (ALNS)
-            chooseDestroyHeuristicbyALNS();
+        runIteration();
+    }
 
-        switch (init_destroy_strategy)
-        {
-            case TARGET_BASED:
-                succ = generateNeighborByTarget();
-                break;
-            case COLLISION_BASED:
-                succ = generateNeighborByCollisionGraph();
-                break;
-            case RANDOM_BASED:
-                succ = generateNeighborRandomly();
-                break;
-            default:
-                cerr << "Wrong neighbor generation strategy" << endl;
-                exit(-1);
-        }
-        if(!succ || neighbor.agents.empty())
-            continue;
+    printResult();
+    return (num_of_colliding_pairs == 0);
+}
+// destroy and repair one neighbor
+void InitLNS::runIteration()
+{
+    bool succ;
+    if (ALNS)
+        chooseDestroyHeuristicbyALNS();
 
-        // get colliding pairs
-        neighbor.old_colliding_pairs.clear();
-        for (int a : neighbor.agents)
+    switch (init_destroy_strategy)
+    {
+        case TARGET_BASED:
+            succ = generateNeighborByTarget();
+            break;
+        case COLLISION_BASED:
+            succ = generateNeighborByCollisionGraph();
+            break;
+        case RANDOM_BASED:
+            succ = generateNeighborRandomly();
+            break;
+        default:
+            cerr << "Wrong neighbor generation strategy" << endl;
+            exit(-1);
+    }
+    if(!succ || neighbor.agents.empty())
+        return;
+
+    // get colliding pairs
+    neighbor.old_colliding_pairs.clear();
+    for (int a : neighbor.agents)
+    {
+        for (auto j: collision_graph[a])
         {
-            for (auto j: collision_graph[a])
-            {
-                neighbor.old_colliding_pairs.emplace(min(a, j), max(a, j));
-            }
+            neighbor.old_colliding_pairs.emplace(min(a, j), max(a, j));
         }
-        if (neighbor.old_colliding_pairs.empty()) // no need to replan
+    }
+    if (neighbor.old_colliding_pairs.empty()) // no need to replan
+    {
+        assert(init_destroy_strategy == RANDOM_BASED);
+        if (ALNS) // update destroy heuristics
         {
-            assert(init_destroy_strategy == RANDOM_BASED);
-            if (ALNS) // update destroy heuristics
-            {
-                destroy_weights[selected_neighbor] = (1 - decay_factor) * destroy_weights[selected_neighbor];
-            }
-            continue;
+            destroy_weights[selected_neighbor] = (1 - decay_factor) * destroy_weights[selected_neighbor];
         }
+        return;
+    }
 
-        // store the neighbor information
-        neighbor.old_paths.resize(neighbor.agents.size());
-        neighbor.old_sum_of_costs = 0;
-        for (int i = 0; i < (int)neighbor.agents.size(); i++)
+    // store the neighbor information
+    neighbor.resizeOldPaths();
+    neighbor.old_sum_of_costs = 0;
+    for (int i = 0; i < (int)neighbor.agents.size(); i++)
+    {
+        int a = neighbor.agents[i];
+        if (replan_algo_name == "PP" || neighbor.agents.size() == 1)
+            neighbor.old_paths[i] = agents[a].path;
+        path_table.deletePath(neighbor.agents[i]);
+        neighbor.old_sum_of_costs += (int) agents[a].path.size() - 1;
+    }
+    if (screen >= 2)
+    {
+        cout << "Neighbors: ";
+        for (auto a : neighbor.agents)
+            cout << a << ", ";
+        cout << endl;
+        cout << "Old colliding pairs (" << neighbor.old_colliding_pairs.size() << "): ";
+        for (const auto & p : neighbor.old_colliding_pairs)
         {
-            int a = neighbor.agents[i];
-            if (replan_algo_name == "PP" || neighbor.agents.size() == 1)
-                neighbor.old_paths[i] = agents[a].path;
-            path_table.deletePath(neighbor.agents[i]);
-            neighbor.old_sum_of_costs += (int) agents[a].path.size() - 1;
+            cout << "(" << p.first << "," << p.second << "), ";
         }
-        if (screen >= 2)
-        {
-            cout << "Neighbors: ";
-            for (auto a : neighbor.agents)
-                cout << a << ", ";
-            cout << endl;
-            cout << "Old colliding pairs (" << neighbor.old_colliding_pairs.size() << "): ";
-            for (const auto & p : neighbor.old_colliding_pairs)
-            {
-                cout << "(" << p.first << "," << p.second << "), ";
-            }
-            cout << endl;
+        cout << endl;
 
-        }
+    }
 
-        if (replan_algo_name == "PP" || neighbor.agents.size() == 1)
-            succ = runPP();
-        else if (replan_algo_name == "GCBS")
-            succ = runGCBS();
-        else if (replan_algo_name == "PBS")
-            succ = runPBS();
+    if (replan_algo_name == "PP" || neighbor.agents.size() == 1)
+        succ = runPP();
+    else if (replan_algo_name == "GCBS")
+        succ = runGCBS();
+    else if (replan_algo_name == "PBS")
+        succ = runPBS();
+    else
+    {
+        cerr << "Wrong replanning strategy" << endl;
+        exit(-1);
+    }
+
+    if (ALNS) // update destroy heuristics
+    {
+        if (neighbor.colliding_pairs.size() < neighbor.old_colliding_pairs.size())
+            destroy_weights[selected_neighbor] =
+                    reaction_factor * (double)(neighbor.old_colliding_pairs.size() -
+                    neighbor.colliding_pairs.size()) // / neighbor.agents.size()
+                    + (1 - reaction_factor) * destroy_weights[selected_neighbor];
         else
+            destroy_weights[selected_neighbor] =
+                    (1 - decay_factor) * destroy_weights[selected_neighbor];
+    }
+    if (screen >= 2)
+        cout << "New colliding pairs = " << neighbor.colliding_pairs.size() << endl;
+    if (succ) // update collision graph
+    {
+        num_of_colliding_pairs += (int)neighbor.colliding_pairs.size() - (int)neighbor.old_colliding_pairs.size();
+        for(const auto& agent_pair : neighbor.old_colliding_pairs)
         {
-            cerr << "Wrong replanning strategy" << endl;
-            exit(-1);
+            collision_graph[agent_pair.first].erase(agent_pair.second);
+            collision_graph[agent_pair.second].erase(agent_pair.first);
         }
-
-        if (ALNS) // update destroy heuristics
+        for(const auto& agent_pair : neighbor.colliding_pairs)
         {
-            if (neighbor.colliding_pairs.size() < neighbor.old_colliding_pairs.size())
-                destroy_weights[selected_neighbor] =
-                        reaction_factor * (double)(neighbor.old_colliding_pairs.size() -
-                        neighbor.colliding_pairs.size()) // / neighbor.agents.size()
-                        + (1 - reaction_factor) * destroy_weights[selected_neighbor];
-            else
-                destroy_weights[selected_neighbor] =
-                        (1 - decay_factor) * destroy_weights[selected_neighbor];
+            collision_graph[agent_pair.first].emplace(agent_pair.second);
+            collision_graph[agent_pair.second].emplace(agent_pair.first);
         }
         if (screen >= 2)
-            cout << "New colliding pairs = " << neighbor.colliding_pairs.size() << endl;
-        if (succ) // update collision graph
-        {
-            num_of_colliding_pairs += (int)neighbor.colliding_pairs.size() - (int)neighbor.old_colliding_pairs.size();
-            for(const auto& agent_pair : neighbor.old_colliding_pairs)
-            {
-                collision_graph[agent_pair.first].erase(agent_pair.second);
-                collision_graph[agent_pair.second].erase(agent_pair.first);
-            }
-            for(const auto& agent_pair : neighbor.colliding_pairs)
-            {
-                collision_graph[agent_pair.first].emplace(agent_pair.second);
-                collision_graph[agent_pair.second].emplace(agent_pair.first);
-            }
-            if (screen >= 2)
-                printCollisionGraph();
-        }
-        runtime = ((fsec)(Time::now() - start_time)).count();
-        sum_of_costs += neighbor.sum_of_costs - neighbor.old_sum_of_costs;
-        if (screen >= 1)
-            cout << "Iteration " << iteration_stats.size() << ", "
-                 << "group size = " << neighbor.agents.size() << ", "
-                 << "colliding pairs = " << num_of_colliding_pairs << ", "
-                 << "solution cost = " << sum_of_costs << ", "
-                 << "remaining time = " << time_limit - runtime << endl;
-        iteration_stats.emplace_back(neighbor.agents.size(), sum_of_costs, runtime, replan_algo_name,
-                                     0, num_of_colliding_pairs);
+            printCollisionGraph();
     }
-
-    printResult();
-    return (num_of_colliding_pairs == 0);
+    runtime = ((fsec)(Time::now() - start_time)).count();
+    sum_of_costs += neighbor.sum_of_costs - neighbor.old_sum_of_costs;
+    if (screen >= 1)
+        cout << "Iteration " << iteration_stats.size() << ", "
+             << "group size = " << neighbor.agents.size() << ", "
+             << "colliding pairs = " << num_of_colliding_pairs << ", "
+             << "solution cost = " << sum_of_costs << ", "
+             << "remaining time = " << time_limit - runtime << endl;
+    iteration_stats.emplace_back(neighbor.agents.size(), sum_of_costs, runtime, replan_algo_name,
+                                 0, num_of_colliding_pairs);
 }
 bool InitLNS::runGCBS()
 {
@@ -311,7 +329,7 @@ bool InitLNS::runPP()
     while (p != shuffled_agents.end() && ((fsec)(Time::now() - time)).count() < T)
     {
         int id = *p;
-        agents[id].path = agents[id].path_planner->findPath(constraint_table);
+        agents[id].path_planner->findPath(constraint_table, agents[id].path);
         assert(!agents[id].path.empty() && agents[id].path.back().location == agents[id].path_planner->goal_location);
         if (agents[id].path_planner->num_collisions > 0)
             updateCollidingPairs(neighbor.colliding_pairs, agents[id].id, agents[id].path);
@@ -353,7 +371,7 @@ bool InitLNS::runPP()
             for (int i = 0; i < (int)neighbor.agents.size(); i++)
             {
                 int a = *p2;
-                agents[a].path = neighbor.old_paths[i];
+                agents[a].path.swap(neighbor.old_paths[i]);
                 path_table.insertPath(agents[a].id);
                 ++p2;
             }
@@ -363,6 +381,321 @@ bool InitLNS::runPP()
     }
 }
 
+void InitLNS::runInParallel()
+{
+    vector<InitLNSWorker> workers;
+    workers.reserve(num_of_threads);
+    for (int k = 0; k < num_of_threads; k++)
+    {
+        std::seed_seq seeds{instance.getRandomSeed(), k};
+        workers.emplace_back(instance.map_size, (int)agents.size(), seeds);
+    }
+    vector<int> owners; // the worker that replans the agent in the current round
+    vector<Path*> paths(agents.size());
+    for (int i = 0; i < (int)agents.size(); i++)
+        paths[i] = &agents[i].path;
+
+    // the worker threads are started once and wait for the next round, in which worker k replans its neighbor
+    // if k < num_of_neighbors; the main thread is worker 0
+    std::mutex round_mutex;
+    std::condition_variable round_started, round_finished;
+    int round = 0, num_of_neighbors = 0, num_of_running_threads = 0;
+    double T = 0;
+    bool stop = false;
+    vector<std::thread> threads;
+    threads.reserve(num_of_threads - 1);
+    for (int k = 1; k < num_of_threads; k++)
+    {
+        threads.emplace_back([&, k]()
+        {
+            std::unique_lock<std::mutex> lock(round_mutex);
+            for (int last_round = 0; ; last_round = round)
+            {
+                round_started.wait(lock, [&]() { return stop or round > last_round; });
+                if (stop)
+                    return;
+                if (k < num_of_neighbors)
+                {
+                    lock.unlock();
+                    workers[k].succ = runPP(workers[k], T);
+                    lock.lock();
+                }
+                if (--num_of_running_threads == 0)
+                    round_finished.notify_one();
+            }
+        });
+    }
+    while (runtime < time_limit and num_of_colliding_pairs > 0)
+    {
+        assert(instance.validateSolution(paths, sum_of_costs, num_of_colliding_pairs));
+        num_of_neighbors = generateDisjointNeighbors(workers, owners);
+        if (num_of_neighbors == 0) // too few components to keep the threads busy
+        {
+            runIteration();
+            continue;
+        }
+
+        // store the neighbor information
+        for (int k = 0; k < num_of_neighbors; k++)
+        {
+            auto& nb = workers[k].neighbor;
+            nb.old_colliding_pairs.clear();
+            for (int a : nb.agents)
+            {
+                for (auto j: collision_graph[a])
+                    nb.old_colliding_pairs.emplace(min(a, j), max(a, j));
+            }
+            if (nb.old_colliding_pairs.empty()) // no need to replan
+            {
+                if (ALNS)
+                    destroy_weights[workers[k].selected_neighbor] =
+                            (1 - decay_factor) * destroy_weights[workers[k].selected_neighbor];
+                nb.agents.clear();
+            }
+            nb.resizeOldPaths();
+            nb.old_sum_of_costs = 0;
+            for (int i = 0; i < (int)nb.agents.size(); i++)
+            {
+                nb.old_paths[i] = agents[nb.agents[i]].path;
+                nb.old_sum_of_costs += (int) nb.old_paths[i].size() - 1;
+            }
+        }
+
+        runtime = ((fsec)(Time::now() - start_time)).count();
+        {
+            std::lock_guard<std::mutex> lock(round_mutex);
+            T = min(time_limit - runtime, replan_time_limit);
+            num_of_running_threads = num_of_threads - 1;
+            round++;
+        }
+        round_started.notify_all();
+        workers[0].succ = runPP(workers[0], T);
+        {
+            std::unique_lock<std::mutex> lock(round_mutex);
+            round_finished.wait(lock, [&]() { return num_of_running_threads == 0; });
+        }
+
+        // merge the repairs one by one
+        for (int k = 0; k < num_of_neighbors; k++)
+        {
+            auto& nb = workers[k].neighbor;
+            if (nb.agents.empty())
+                continue;
+            if (!workers[k].succ)
+            {
+                num_of_failures++;
+                nb.sum_of_costs = nb.old_sum_of_costs;
+            }
+            else if (!mergeRepair(workers, owners, k))
+            {
+                num_of_rejected_repairs++;
+                workers[k].succ = false;
+            }
+            else // update collision graph
+            {
+                num_of_colliding_pairs += (int)nb.colliding_pairs.size() - (int)nb.old_colliding_pairs.size();
+                for(const auto& agent_pair : nb.old_colliding_pairs)
+                {
+                    collision_graph[agent_pair.first].erase(agent_pair.second);
+                    collision_graph[agent_pair.second].erase(agent_pair.first);
+                }
+                for(const auto& agent_pair : nb.colliding_pairs)
+                {
+                    collision_graph[agent_pair.first].emplace(agent_pair.second);
+                    collision_graph[agent_pair.second].emplace(agent_pair.first);
+                }
+            }
+            if (ALNS) // update destroy heuristics
+            {
+                auto& weight = destroy_weights[workers[k].selected_neighbor];
+                if (workers[k].succ)
+                    weight = reaction_factor * (double)(nb.old_colliding_pairs.size() - nb.colliding_pairs.size())
+                            + (1 - reaction_factor) * weight;
+                else
+                    weight = (1 - decay_factor) * weight;
+            }
+            runtime = ((fsec)(Time::now() - start_time)).count();
+            sum_of_costs += nb.sum_of_costs - nb.old_sum_of_costs;
+            if (screen >= 1)
+                cout << "Iteration " << iteration_stats.size() << ", "
+                     << "worker " << k << ", "
+                     << "group size = " << nb.agents.size() << ", "
+                     << "colliding pairs = " << num_of_colliding_pairs << ", "
+                     << "solution cost = " << sum_of_costs << ", "
+                     << "remaining time = " << time_limit - runtime << endl;
+            iteration_stats.emplace_back(nb.agents.size(), sum_of_costs, runtime, replan_algo_name,
+                                         0, num_of_colliding_pairs);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(round_mutex);
+        stop = true;
+    }
+    round_started.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+    if (screen >= 1)
+        cout << "Parallel InitLNS with " << num_of_threads << " threads: "
+             << "rejected repairs = " << num_of_rejected_repairs << endl;
+}
+
+// pick up to num_of_threads connected components of the collision graph and generate one neighbor in each of them
+int InitLNS::generateDisjointNeighbors(vector<InitLNSWorker>& workers, vector<int>& owners)
+{
+    vector<int> all_vertices;
+    all_vertices.reserve(collision_graph.size());
+    for (int i = 0; i < (int)collision_graph.size(); i++)
+    {
+        if (!collision_graph[i].empty())
+            all_vertices.push_back(i);
+    }
+    std::random_shuffle(all_vertices.begin(), all_vertices.end()); // larger components are more likely to be picked
+    vector< unordered_map<int, set<int>> > components;
+    owners.assign(agents.size(), -1);
+    for (int v : all_vertices)
+    {
+        if (owners[v] >= 0)
+            continue;
+        components.emplace_back();
+        findConnectedComponent(collision_graph, v, components.back());
+        for (const auto& node : components.back())
+            owners[node.first] = (int)components.size() - 1;
+        if ((int)components.size() == num_of_threads)
+            break;
+    }
+    if ((int)components.size() < num_of_threads)
+        return 0;
+    for (int k = 0; k < (int)components.size(); k++)
+    {
+        // generate the neighbor by the destroy heuristic of the worker, but only with the agents that are not
+        // in the components or neighbors of the other workers
+        if (ALNS)
+            chooseDestroyHeuristicbyALNS();
+        workers[k].selected_neighbor = selected_neighbor;
+        set<int> neighbors_set;
+        switch (init_destroy_strategy)
+        {
+            case TARGET_BASED:
+                generateNeighborByTarget();
+                neighbors_set.insert(neighbor.agents.begin(), neighbor.agents.end());
+                break;
+            case COLLISION_BASED:
+                generateNeighborInComponent(components[k], neighbors_set, owners);
+                break;
+            case RANDOM_BASED:
+                generateNeighborRandomly();
+                neighbors_set.insert(neighbor.agents.begin(), neighbor.agents.end());
+                break;
+            default:
+                cerr << "Wrong neighbor generation strategy" << endl;
+                exit(-1);
+        }
+        workers[k].neighbor.agents.clear();
+        for (int a : neighbors_set)
+        {
+            if (owners[a] < 0 or owners[a] == k)
+            {
+                owners[a] = k;
+                workers[k].neighbor.agents.push_back(a);
+            }
+        }
+    }
+    owners.assign(agents.size(), -1); // only the agents in the neighbors are owned by the workers
+    for (int k = 0; k < (int)components.size(); k++)
+    {
+        for (int a : workers[k].neighbor.agents)
+            owners[a] = k;
+    }
+    if (screen >= 2)
+        cout << "Generate " << components.size() << " neighbors in disjoint components of the collision graph" << endl;
+    return (int)components.size();
+}
+
+// replan the neighbor of the worker by PP against its view of the shared path table,
+// which ignores the old paths of the neighbor and sees the new paths that the worker has planned so far
+bool InitLNS::runPP(InitLNSWorker& worker, double T)
+{
+    auto& nb = worker.neighbor;
+    for (int a : nb.agents)
+        worker.in_neighbor[a] = true;
+    PathTableWCView view(path_table, worker.in_neighbor, worker.new_path_table);
+    vector<int> order(nb.agents.size());
+    for (int i = 0; i < (int)order.size(); i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), worker.random_generator);
+    worker.new_paths.resize(nb.agents.size());
+    nb.sum_of_costs = 0;
+    nb.colliding_pairs.clear();
+    auto time = Time::now();
+    ConstraintTable constraint_table(instance.num_of_cols, instance.map_size, nullptr, &view);
+    auto p = order.begin();
+    while (p != order.end() && ((fsec)(Time::now() - time)).count() < T)
+    {
+        int id = nb.agents[*p];
+        auto& path = worker.new_paths[*p];
+        agents[id].path_planner->findPath(constraint_table, path);
+        assert(!path.empty() && path.back().location == agents[id].path_planner->goal_location);
+        if (agents[id].path_planner->num_collisions > 0)
+            updateCollidingPairs(nb.colliding_pairs, id, path, view);
+        nb.sum_of_costs += (int)path.size() - 1;
+        if (nb.colliding_pairs.size() >= nb.old_colliding_pairs.size())
+            break;
+        worker.new_path_table.insertPath(id, path);
+        ++p;
+    }
+    bool succ = (p == order.end());
+    for (auto p2 = order.begin(); p2 != p; ++p2)
+        worker.new_path_table.deletePath(nb.agents[*p2]);
+    for (int a : nb.agents)
+        worker.in_neighbor[a] = false;
+    return succ;
+}
+
+// commit the new paths of the k-th worker to the shared path table.
+// The new paths are accepted only if they reduce the colliding pairs and do not collide with the agents
+// that other workers have repaired in this round, as the worker did not see the new paths of those agents.
+bool InitLNS::mergeRepair(vector<InitLNSWorker>& workers, const vector<int>& owners, int k)
+{
+    auto& nb = workers[k].neighbor;
+    nb.old_colliding_pairs.clear(); // the repairs merged earlier in this round may have changed the colliding pairs
+    for (int a : nb.agents)
+    {
+        for (auto j: collision_graph[a])
+            nb.old_colliding_pairs.emplace(min(a, j), max(a, j));
+    }
+    for (int a : nb.agents)
+        path_table.deletePath(a);
+    nb.colliding_pairs.clear();
+    for (int i = 0; i < (int)nb.agents.size(); i++)
+    {
+        int a = nb.agents[i];
+        agents[a].path.swap(workers[k].new_paths[i]);
+        updateCollidingPairs(nb.colliding_pairs, a, agents[a].path);
+        path_table.insertPath(a, agents[a].path);
+    }
+    bool succ = nb.colliding_pairs.size() < nb.old_colliding_pairs.size();
+    for (auto it = nb.colliding_pairs.begin(); succ and it != nb.colliding_pairs.end(); ++it)
+    {
+        for (int a : {it->first, it->second})
+        {
+            if (owners[a] >= 0 and owners[a] < k and workers[owners[a]].succ)
+                succ = false;
+        }
+    }
+    if (!succ) // roll back
+    {
+        for (int i = 0; i < (int)nb.agents.size(); i++)
+        {
+            int a = nb.agents[i];
+            path_table.deletePath(a);
+            agents[a].path.swap(nb.old_paths[i]);
+            path_table.insertPath(a);
+        }
+        nb.sum_of_costs = nb.old_sum_of_costs;
+    }
+    return succ;
+}
+
 bool InitLNS::getInitialSolution()
 {
     neighbor.agents.clear();
@@ -384,7 +717,7 @@ bool InitLNS::getInitialSolution()
     set<pair<int, int>> colliding_pairs;
     for (auto id : neighbor.agents)
     {
-        agents[id].path = agents[id].path_planner->findPath(constraint_table);
+        agents[id].path_planner->findPath(constraint_table, agents[id].path);
         assert(!agents[id].path.empty() && agents[id].path.back().location == agents[id].path_planner->goal_location);
         if (agents[id].path_planner->num_collisions > 0)
             updateCollidingPairs(colliding_pairs, agents[id].id, agents[id].path);
@@ -415,7 +748,10 @@ bool InitLNS::getInitialSolution()
 }
 
 // return true if the new p[ath has collisions;
-bool InitLNS::updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path) const
+// the table is either the shared path table or the view of a worker
+template <class T>
+static bool updateCollidingPairsInTable(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path,
+                                        const T& table)
 {
     bool succ = false;
     if (path.size() < 2)
@@ -424,57 +760,63 @@ bool InitLNS::updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int age
     {
         int from = path[t - 1].location;
         int to = path[t].location;
-        if ((int)path_table.table[to].size() > t) // vertex conflicts
+        table.forEachAgent(to, t, [&](int id) // vertex conflicts
         {
-            for (auto id : path_table.table[to][t])
-            {
-                succ = true;
-                colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
-            }
-        }
-        if (from != to && path_table.table[to].size() >= t && path_table.table[from].size() > t) // edge conflicts
+            succ = true;
+            colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
+        });
+        if (from != to) // edge conflicts
         {
-            for (auto a1 : path_table.table[to][t - 1])
+            table.forEachAgent(to, t - 1, [&](int a1)
             {
-                for (auto a2: path_table.table[from][t])
+                table.forEachAgent(from, t, [&](int a2)
                 {
                     if (a1 == a2)
                     {
                         succ = true;
                         colliding_pairs.emplace(min(agent_id, a1), max(agent_id, a1));
-                        break;
                     }
-                }
-            }
+                });
+            });
         }
         //auto id = getAgentWithTarget(to, t);
         //if (id >= 0) // this agent traverses the target of another agent
         //    colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
-        if (!path_table.goals.empty() && path_table.goals[to] < t) // target conflicts
+        if (!table.empty() && table.getGoalTime(to) < t) // target conflicts
         { // this agent traverses the target of another agent
-            for (auto id : path_table.table[to][path_table.goals[to]]) // look at all agents at the goal time
+            table.forEachAgent(to, table.getGoalTime(to), [&](int id) // look at all agents at the goal time
             {
-                if (agents[id].path.back().location == to) // if agent id's goal is to, then this is the agent we want
+                if (table.getPath(id)->back().location == to) // if agent id's goal is to, then this is the agent we want
                 {
                     succ = true;
                     colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
-                    break;
                 }
-            }
+            });
         }
     }
     int goal = path.back().location; // target conflicts - some other agent traverses the target of this agent
-    for (int t = (int)path.size(); t < path_table.table[goal].size(); t++)
+    for (int t = (int)path.size(); t < table.getLength(goal); t++)
     {
-        for (auto id : path_table.table[goal][t])
+        table.forEachAgent(goal, t, [&](int id)
         {
             succ = true;
             colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
-        }
+        });
     }
     return succ;
 }
 
+bool InitLNS::updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path) const
+{
+    return updateCollidingPairsInTable(colliding_pairs, agent_id, path, path_table);
+}
+
+bool InitLNS::updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path,
+                                   const PathTableWCView& table) const
+{
+    return updateCollidingPairsInTable(colliding_pairs, agent_id, path, table);
+}
+
 void InitLNS::chooseDestroyHeuristicbyALNS()
 {
     rouletteWheel();
@@ -551,6 +893,16 @@ bool InitLNS::generateNeighborByCollisionGraph()
 
     assert(neighbor_size <= (int)agents.size());
     set<int> neighbors_set;
+    generateNeighborInComponent(G, neighbors_set, vector<int>());
+    neighbor.agents.assign(neighbors_set.begin(), neighbors_set.end());
+    if (screen >= 2)
+        cout << "Generate " << neighbor.agents.size() << " neighbors by collision graph" << endl;
+    return true;
+
+}
+void InitLNS::generateNeighborInComponent(unordered_map<int, set<int>>& G, set<int>& neighbors_set,
+                                          const vector<int>& owners)
+{
     if ((int)G.size() <= neighbor_size)
     {
         for (const auto& node : G)
@@ -560,7 +912,7 @@ bool InitLNS::generateNeighborByCollisionGraph()
         {
             int a1 = *std::next(neighbors_set.begin(), rand() % neighbors_set.size());
             int a2 = randomWalk(a1);
-            if (a2 != NO_AGENT)
+            if (a2 != NO_AGENT and (owners.empty() or owners[a2] < 0))
                 neighbors_set.insert(a2);
             else
                 count++;
@@ -576,11 +928,6 @@ bool InitLNS::generateNeighborByCollisionGraph()
             neighbors_set.insert(a);
         }
     }
-    neighbor.agents.assign(neighbors_set.begin(), neighbors_set.end());
-    if (screen >= 2)
-        cout << "Generate " << neighbor.agents.size() << " neighbors by collision graph" << endl;
-    return true;
-
 }
 bool InitLNS::generateNeighborByTarget()
 {
@@ -738,11 +1085,9 @@ int InitLNS::randomWalk(int agent_id)
            path_table.table[loc][t].empty() or
            (path_table.table[loc][t].size() == 1 and path_table.table[loc][t].front() == agent_id)))
     {
-        auto next_locs = instance.getNeighbors(loc);
-        next_locs.push_back(loc);
+        auto next_locs = instance.getNextLocations(loc);
         int step = rand() % next_locs.size();
-        auto it = next_locs.begin();
-        loc = *std::next(next_locs.begin(), rand() % next_locs.size());
+        loc = next_locs[rand() % next_locs.size()];
         t = t + 1;
     }
     if (t > path_table.makespan)
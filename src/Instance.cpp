@@ -2,6 +2,14 @@
 #include <algorithm>    // std::shuffle
 #include <random>      // std::default_random_engine
 #include <chrono>       // std::chrono::system_clock
+#include <atomic>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include"Instance.h"
 
 int RANDOM_WALK_STEPS = 100000;
@@ -25,6 +33,7 @@ Instance::Instance(const string& map_fname, const string& agent_fname,
 			exit(-1);
 		}
 	}
+	buildNeighbors();
 
 	succ = loadAgents();
 	if (!succ)
@@ -41,7 +50,48 @@ Instance::Instance(const string& map_fname, const string& agent_fname,
 			exit(-1);
 		}
 	}
+}
 
+void Instance::resizeMap(int rows, int cols)
+{
+	num_of_rows = rows;
+	num_of_cols = cols;
+	map_size = num_of_rows * num_of_cols;
+	my_map.assign(map_size, false);
+	coordinates.resize(map_size);
+	for (int loc = 0; loc < map_size; loc++)
+		coordinates[loc] = make_pair(loc / num_of_cols, loc % num_of_cols);
+}
+
+void Instance::buildNeighbors()
+{
+	// a copy of the map with a border of obstacles, so that the neighbors of every location can be looked up
+	// without checking whether they are on the map
+	int padded_cols = num_of_cols + 2;
+	vector<bool> padded_map((num_of_rows + 2) * padded_cols, true);
+	for (int loc = 0; loc < map_size; loc++)
+		padded_map[(coordinates[loc].first + 1) * padded_cols + coordinates[loc].second + 1] = my_map[loc];
+
+	free_moves.resize(map_size);
+	neighbor_offsets.resize(map_size + 1);
+	neighbors.clear();
+	neighbors.reserve(5 * map_size);
+	for (int curr = 0; curr < map_size; curr++)
+	{
+		int padded_curr = (coordinates[curr].first + 1) * padded_cols + coordinates[curr].second + 1;
+		free_moves[curr] = (uint8_t)(!padded_map[padded_curr] * FREE | !padded_map[padded_curr + 1] * EAST |
+		        !padded_map[padded_curr - 1] * WEST | !padded_map[padded_curr + padded_cols] * SOUTH |
+		        !padded_map[padded_curr - padded_cols] * NORTH);
+		neighbor_offsets[curr] = (int)neighbors.size();
+		int candidates[4] = {curr + 1, curr - 1, curr + num_of_cols, curr - num_of_cols};
+		for (int next : candidates)
+		{
+			if (validMove(curr, next))
+				neighbors.push_back(next);
+		}
+		neighbors.push_back(curr);
+	}
+	neighbor_offsets[map_size] = (int)neighbors.size();
 }
 
 
@@ -49,8 +99,8 @@ int Instance::randomWalk(int curr, int steps) const
 {
 	for (int walk = 0; walk < steps; walk++)
 	{
-		list<int> l = getNeighbors(curr);
-		vector<int> next_locations(l.cbegin(), l.cend());
+		auto neighbors = getNeighbors(curr);
+		vector<int> next_locations(neighbors.begin(), neighbors.end());
 		auto rng = std::default_random_engine{};
 		std::shuffle(std::begin(next_locations), std::end(next_locations), rng);
 		for (int next : next_locations)
@@ -194,9 +244,10 @@ bool Instance::isConnected(int start, int goal)
 		int curr = open.front(); open.pop();
 		if (curr == goal)
 			return true;
-		for (int next : getNeighbors(curr))
+		int candidates[4] = {curr + 1, curr - 1, curr + num_of_cols, curr - num_of_cols};
+		for (int next : candidates) // not validMove, as it is called while the map is being generated
 		{
-			if (closed[next])
+			if (next < 0 or next >= map_size or my_map[next] or getManhattanDistance(curr, next) > 1 or closed[next])
 				continue;
 			open.push(next);
 			closed[next] = true;
@@ -209,10 +260,7 @@ void Instance::generateConnectedRandomGrid(int rows, int cols, int obstacles)
 {
 	cout << "Generate a " << rows << " x " << cols << " grid with " << obstacles << " obstacles. " << endl;
 	int i, j;
-	num_of_rows = rows + 2;
-	num_of_cols = cols + 2;
-	map_size = num_of_rows * num_of_cols;
-	my_map.resize(map_size, false);
+	resizeMap(rows + 2, cols + 2);
 	// Possible moves [WAIT, NORTH, EAST, SOUTH, WEST]
 	/*moves_offset[Instance::valid_moves_t::WAIT_MOVE] = 0;
 	moves_offset[Instance::valid_moves_t::NORTH] = -num_of_cols;
@@ -283,8 +331,7 @@ bool Instance::loadMap()
 		beg++;
 		num_of_cols = atoi((*beg).c_str()); // read number of cols
 	}
-	map_size = num_of_cols * num_of_rows;
-	my_map.resize(map_size, false);
+	resizeMap(num_of_rows, num_of_cols);
 	// read map (and start/goal locations)
 	for (int i = 0; i < num_of_rows; i++) {
 		getline(myfile, line);
@@ -470,18 +517,6 @@ void Instance::saveNathan() const
 }
 
 
-list<int> Instance::getNeighbors(int curr) const
-{
-	list<int> neighbors;
-	int candidates[4] = {curr + 1, curr - 1, curr + num_of_cols, curr - num_of_cols};
-	for (int next : candidates)
-	{
-		if (validMove(curr, next))
-			neighbors.emplace_back(next);
-	}
-	return neighbors;
-}
-
 void Instance::savePaths(const string & file_name, const vector<Path*>& paths) const
 {
     std::ofstream output;
@@ -616,4 +651,170 @@ bool Instance::validateSolution(const vector<Path*>& paths, int sum_of_costs, in
     }
     cout << "Done!" << endl;
     return true;
-}
\ No newline at end of file
+}
+
+const int* Instance::getDistances(int goal_location) const
+{
+	DistanceRow* row;
+	{
+		std::lock_guard<std::mutex> lock(distance_table_mutex);
+		if (distance_table.empty())
+			distance_table.resize(map_size);
+		if (distance_table[goal_location] == nullptr)
+			distance_table[goal_location].reset(new DistanceRow());
+		row = distance_table[goal_location].get();
+	}
+	// the rows of different goal locations can be computed by different threads at the same time
+	std::call_once(row->computed, [&]()
+	{
+		if (!distance_cache.empty() and loadDistances(goal_location, *row))
+			return;
+		computeDistances(goal_location, row->distances);
+		row->data = row->distances.data();
+		if (!distance_cache.empty())
+			saveDistances(goal_location, row->distances);
+	});
+	return row->data;
+}
+
+Instance::DistanceRow::~DistanceRow()
+{
+	if (mapped_size > 0)
+		munmap(mapped_data, mapped_size);
+}
+
+void Instance::setDistanceCache(const string& directory)
+{
+	map_hash = getMapHash();
+	char hash_string[17];
+	snprintf(hash_string, sizeof(hash_string), "%016llx", (unsigned long long)map_hash);
+	distance_cache = directory + "/" + hash_string;
+	for (const auto& dir : {directory, distance_cache})
+	{
+		if (mkdir(dir.c_str(), 0777) != 0 and errno != EEXIST)
+		{
+			cerr << "Heuristic cache directory " << dir << " cannot be created." << endl;
+			exit(-1);
+		}
+	}
+}
+
+// FNV-1a hash of the size and the obstacles of the map
+uint64_t Instance::getMapHash() const
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+	add((uint64_t)num_of_rows);
+	add((uint64_t)num_of_cols);
+	for (bool obstacle : my_map)
+		add(obstacle);
+	return hash;
+}
+
+// The header of a cache file. The distances are only used if it matches the map and the goal location,
+// e.g., not if the file was written by another version or for another map with the same hash.
+struct DistanceFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	int32_t num_of_rows;
+	int32_t num_of_cols;
+	int32_t goal_location;
+	uint64_t map_hash;
+};
+static const char DISTANCE_FILE_MAGIC[8] = "MAPFDST";
+static const uint32_t DISTANCE_FILE_VERSION = 1;
+
+static DistanceFileHeader makeDistanceFileHeader(int num_of_rows, int num_of_cols, uint64_t map_hash, int goal_location)
+{
+	DistanceFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DISTANCE_FILE_MAGIC, sizeof(header.magic));
+	header.version = DISTANCE_FILE_VERSION;
+	header.num_of_rows = num_of_rows;
+	header.num_of_cols = num_of_cols;
+	header.goal_location = goal_location;
+	header.map_hash = map_hash;
+	return header;
+}
+
+// map the cache file of the goal location into memory, if it exists and its header matches
+bool Instance::loadDistances(int goal_location, DistanceRow& row) const
+{
+	string file_name = distance_cache + "/" + std::to_string(goal_location) + ".dist";
+	int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	auto expected = makeDistanceFileHeader(num_of_rows, num_of_cols, map_hash, goal_location);
+	DistanceFileHeader header;
+	size_t size = sizeof(header) + map_size * sizeof(int);
+	struct stat file_stat;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &file_stat) == 0 and (size_t)file_stat.st_size == size and // otherwise, the file is broken
+		pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) and
+		memcmp(&header, &expected, sizeof(header)) == 0)
+		data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	row.data = (const int*)((const char*)data + sizeof(header));
+	row.mapped_data = data;
+	row.mapped_size = size;
+	return true;
+}
+
+// write the cache file of the goal location. The file is written under a temporary name and then renamed,
+// so other runs that use the cache at the same time never see a partial file. Failures are ignored.
+void Instance::saveDistances(int goal_location, const vector<int>& distances) const
+{
+	string file_name = distance_cache + "/" + std::to_string(goal_location) + ".dist";
+	string temp_name = file_name + ".XXXXXX";
+	int fd = mkstemp(&temp_name[0]);
+	if (fd < 0)
+		return;
+	auto header = makeDistanceFileHeader(num_of_rows, num_of_cols, map_hash, goal_location);
+	size_t size = distances.size() * sizeof(int);
+	bool succ = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) and
+		write(fd, distances.data(), size) == (ssize_t)size;
+	succ = close(fd) == 0 and succ;
+	if (!succ or rename(temp_name.c_str(), file_name.c_str()) != 0)
+		unlink(temp_name.c_str());
+}
+
+void Instance::precomputeDistances(int num_of_threads) const
+{
+	std::atomic<int> next_agent(0);
+	auto work = [&]()
+	{
+		for (int i = next_agent++; i < num_of_agents; i = next_agent++)
+			getDistances(goal_locations[i]);
+	};
+	vector<std::thread> workers;
+	for (int i = 1; i < num_of_threads; i++)
+		workers.emplace_back(work);
+	work();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+// unit-cost edges, so a breadth-first search suffices
+void Instance::computeDistances(int goal_location, vector<int>& distances) const
+{
+	distances.assign(map_size, MAX_TIMESTEP);
+	vector<int> queue; // the locations in the order of their distances
+	queue.reserve(map_size);
+	distances[goal_location] = 0;
+	queue.push_back(goal_location);
+	for (size_t head = 0; head < queue.size(); head++)
+	{
+		int curr = queue[head];
+		for (int next : getNeighbors(curr))
+		{
+			if (distances[next] == MAX_TIMESTEP)
+			{
+				distances[next] = distances[curr] + 1;
+				queue.push_back(next);
+			}
+		}
+	}
+}
@@ -1,24 +1,29 @@
 #include "LNS.h"
 #include "ECBS.h"
 #include <queue>
+#include <thread>
+#include <functional>
 
 LNS::LNS(const Instance& instance, double time_limit, const string & init_algo_name, const string & replan_algo_name,
          const string & destory_name, int neighbor_size, int num_of_iterations, bool use_init_lns,
-         const string & init_destory_name, bool use_sipp, int screen, PIBTPPS_option pipp_option) :
+         const string & init_destory_name, bool use_sipp, int screen, PIBTPPS_option pipp_option,
+         int num_of_threads, bool adaptive_neighbor_size, bool adaptive_replan_time) :
          BasicLNS(instance, time_limit, neighbor_size, screen),
          init_algo_name(init_algo_name),  replan_algo_name(replan_algo_name), num_of_iterations(num_of_iterations),
-         use_init_lns(use_init_lns),init_destory_name(init_destory_name),
-         path_table(instance.map_size), pipp_option(pipp_option)
+         use_init_lns(use_init_lns), use_sipp(use_sipp), init_destory_name(init_destory_name),
+         path_table(instance.map_size, true), pipp_option(pipp_option), num_of_threads(num_of_threads),
+         adaptive_neighbor_size(adaptive_neighbor_size), adaptive_replan_time(adaptive_replan_time),
+         replan_time_limits(time_limit / 100)
 {
     start_time = Time::now();
     replan_time_limit = time_limit / 100;
-    if (destory_name == "Adaptive")
+    if (num_of_threads > 1 and replan_algo_name != "PP")
     {
-        ALNS = true;
-        destroy_weights.assign(DESTORY_COUNT, 1);
-        decay_factor = 0.01;
-        reaction_factor = 0.01;
+        cerr << "Parallel LNS only supports PP as the replanning algorithm. " << endl;
+        exit(-1);
     }
+    if (destory_name == "Adaptive")
+        ALNS = true;
     else if (destory_name == "RandomWalk")
         destroy_strategy = RANDOMWALK;
     else if (destory_name == "Intersection")
@@ -30,7 +35,33 @@ LNS::LNS(const Instance& instance, double time_limit, const string & init_algo_n
         cerr << "Destroy heuristic " << destory_name << " does not exists. " << endl;
         exit(-1);
     }
+    if (ALNS or adaptive_neighbor_size)
+    {
+        vector<destroy_heuristic> heuristics;
+        if (ALNS)
+            heuristics = {RANDOMWALK, INTERSECTION, RANDOMAGENTS};
+        else
+            heuristics = {destroy_strategy};
+        vector<int> neighbor_sizes;
+        if (adaptive_neighbor_size)
+        {
+            for (int size = 2; size <= 32 and size <= instance.getDefaultNumberOfAgents(); size *= 2)
+                neighbor_sizes.push_back(size);
+        }
+        if (neighbor_sizes.empty())
+            neighbor_sizes.push_back(neighbor_size);
+        for (auto heuristic : heuristics)
+        {
+            for (int size : neighbor_sizes)
+                arms.emplace_back(heuristic, size);
+        }
+        ALNS = true;
+        destroy_weights.assign(arms.size(), 1);
+        decay_factor = 0.01;
+        reaction_factor = adaptive_neighbor_size ? 0.1 : 0.01;
+    }
 
+    instance.precomputeDistances(num_of_threads); // the agents below only look up their distances
     int N = instance.getDefaultNumberOfAgents();
     agents.reserve(N);
     for (int i = 0; i < N; i++)
@@ -58,7 +89,7 @@ bool LNS::run()
         if (use_init_lns)
         {
             init_lns = new InitLNS(instance, agents, time_limit - initial_solution_runtime,
-                    replan_algo_name,init_destory_name, neighbor_size, screen);
+                    replan_algo_name,init_destory_name, neighbor_size, screen, num_of_threads);
             succ = init_lns->run();
             if (succ) // accept new paths
             {
@@ -100,9 +131,12 @@ bool LNS::run()
         return false; // terminate because no initial solution is found
     }
 
+    if (num_of_threads > 1)
+        runInParallel(); // this uses up the time limit or the iterations, so the loop below is skipped
     while (runtime < time_limit && iteration_stats.size() <= num_of_iterations)
     {
-        runtime =((fsec)(Time::now() - start_time)).count();
+        auto iteration_start = Time::now();
+        runtime =((fsec)(iteration_start - start_time)).count();
         if(screen >= 1)
             validateSolution();
         if (ALNS)
@@ -117,15 +151,7 @@ bool LNS::run()
                 succ = generateNeighborByIntersection();
                 break;
             case RANDOMAGENTS:
-                neighbor.agents.resize(agents.size());
-                for (int i = 0; i < (int)agents.size(); i++)
-                    neighbor.agents[i] = i;
-                if (neighbor.agents.size() > neighbor_size)
-                {
-                    std::random_shuffle(neighbor.agents.begin(), neighbor.agents.end());
-                    neighbor.agents.resize(neighbor_size);
-                }
-                succ = true;
+                succ = generateNeighborRandomly();
                 break;
             default:
                 cerr << "Wrong neighbor generation strategy" << endl;
@@ -135,7 +161,7 @@ bool LNS::run()
             continue;
 
         // store the neighbor information
-        neighbor.old_paths.resize(neighbor.agents.size());
+        neighbor.resizeOldPaths();
         neighbor.old_sum_of_costs = 0;
         for (int i = 0; i < (int)neighbor.agents.size(); i++)
         {
@@ -145,6 +171,9 @@ bool LNS::run()
             neighbor.old_sum_of_costs += agents[neighbor.agents[i]].path.size() - 1;
         }
 
+        if (adaptive_replan_time)
+            replan_time_limit = replan_time_limits.get((int)neighbor.agents.size());
+        auto replan_start = Time::now();
         if (replan_algo_name == "EECBS")
             succ = runEECBS();
         else if (replan_algo_name == "CBS")
@@ -157,16 +186,10 @@ bool LNS::run()
             exit(-1);
         }
 
+        if (adaptive_replan_time)
+            replan_time_limits.update((int)neighbor.agents.size(), succ, ((fsec)(Time::now() - replan_start)).count());
         if (ALNS) // update destroy heuristics
-        {
-            if (neighbor.old_sum_of_costs > neighbor.sum_of_costs )
-                destroy_weights[selected_neighbor] =
-                        reaction_factor * (neighbor.old_sum_of_costs - neighbor.sum_of_costs) / neighbor.agents.size()
-                        + (1 - reaction_factor) * destroy_weights[selected_neighbor];
-            else
-                destroy_weights[selected_neighbor] =
-                        (1 - decay_factor) * destroy_weights[selected_neighbor];
-        }
+            updateDestroyWeights(selected_neighbor, neighbor, iteration_start);
         runtime = ((fsec)(Time::now() - start_time)).count();
         sum_of_costs += neighbor.sum_of_costs - neighbor.old_sum_of_costs;
         if (screen >= 1)
@@ -190,6 +213,10 @@ bool LNS::run()
          << "solution cost = " << sum_of_costs << ", "
          << "initial solution cost = " << initial_sum_of_costs << ", "
          << "failed iterations = " << num_of_failures << endl;
+    if (ALNS and screen >= 1)
+        printArmStats();
+    if (adaptive_replan_time and screen >= 1)
+        replan_time_limits.print();
     return true;
 }
 
@@ -214,6 +241,8 @@ bool LNS::getInitialSolution()
         succ = runWinPIBT();
     else if (init_algo_name == "CBS")
         succ = runCBS();
+    else if (init_algo_name == "Portfolio")
+        succ = runPortfolio();
     else
     {
         cerr <<  "Initial MAPF solver " << init_algo_name << " does not exist!" << endl;
@@ -242,23 +271,7 @@ bool LNS::runEECBS()
     }
 
     ECBS ecbs(search_engines, screen - 1, &path_table);
-    ecbs.setPrioritizeConflicts(true);
-    ecbs.setDisjointSplitting(false);
-    ecbs.setBypass(true);
-    ecbs.setRectangleReasoning(true);
-    ecbs.setCorridorReasoning(true);
-    ecbs.setHeuristicType(heuristics_type::WDG, heuristics_type::GLOBAL);
-    ecbs.setTargetReasoning(true);
-    ecbs.setMutexReasoning(false);
-    ecbs.setConflictSelectionRule(conflict_selection::EARLIEST);
-    ecbs.setNodeSelectionRule(node_selection::NODE_CONFLICTPAIRS);
-    ecbs.setSavingStats(false);
-    double w;
-    if (iteration_stats.empty())
-        w = 5; // initial run
-    else
-        w = 1.1; // replan
-    ecbs.setHighLevelSolver(high_level_solver_type::EES, w);
+    setUpEECBS(ecbs);
     runtime = ((fsec)(Time::now() - start_time)).count();
     double T = time_limit - runtime;
     if (!iteration_stats.empty()) // replan
@@ -292,6 +305,26 @@ bool LNS::runEECBS()
     }
     return succ;
 }
+void LNS::setUpEECBS(ECBS& ecbs) const
+{
+    ecbs.setPrioritizeConflicts(true);
+    ecbs.setDisjointSplitting(false);
+    ecbs.setBypass(true);
+    ecbs.setRectangleReasoning(true);
+    ecbs.setCorridorReasoning(true);
+    ecbs.setHeuristicType(heuristics_type::WDG, heuristics_type::GLOBAL);
+    ecbs.setTargetReasoning(true);
+    ecbs.setMutexReasoning(false);
+    ecbs.setConflictSelectionRule(conflict_selection::EARLIEST);
+    ecbs.setNodeSelectionRule(node_selection::NODE_CONFLICTPAIRS);
+    ecbs.setSavingStats(false);
+    double w;
+    if (iteration_stats.empty())
+        w = 5; // initial run
+    else
+        w = 1.1; // replan
+    ecbs.setHighLevelSolver(high_level_solver_type::EES, w);
+}
 bool LNS::runCBS()
 {
     if (screen >= 2)
@@ -363,6 +396,9 @@ bool LNS::runPP()
     int remaining_agents = (int)shuffled_agents.size();
     auto p = shuffled_agents.begin();
     neighbor.sum_of_costs = 0;
+    int lowerbound = 0; // the sum of the distances of the agents that have not been replanned
+    for (int id : shuffled_agents)
+        lowerbound += agents[id].path_planner->my_heuristic[agents[id].path_planner->start_location];
     runtime = ((fsec)(Time::now() - start_time)).count();
     double T = time_limit - runtime; // time limit
     if (!iteration_stats.empty()) // replan
@@ -376,11 +412,13 @@ bool LNS::runPP()
             cout << "Remaining agents = " << remaining_agents <<
                  ", remaining time = " << T - ((fsec)(Time::now() - time)).count() << " seconds. " << endl
                  << "Agent " << agents[id].id << endl;
-        agents[id].path = agents[id].path_planner->findPath(constraint_table);
+        // the new paths have to cost less than the old ones in total, so the search gives up on the paths that leave
+        // less than the distances of the remaining agents
+        lowerbound -= agents[id].path_planner->my_heuristic[agents[id].path_planner->start_location];
+        agents[id].path_planner->findPath(constraint_table, agents[id].path,
+                                          neighbor.old_sum_of_costs - 1 - neighbor.sum_of_costs - lowerbound);
         if (agents[id].path.empty()) break;
         neighbor.sum_of_costs += (int)agents[id].path.size() - 1;
-        if (neighbor.sum_of_costs >= neighbor.old_sum_of_costs)
-            break;
         remaining_agents--;
         path_table.insertPath(agents[id].id, agents[id].path);
         ++p;
@@ -406,7 +444,7 @@ bool LNS::runPP()
             for (int i = 0; i < (int)neighbor.agents.size(); i++)
             {
                 int a = *p2;
-                agents[a].path = neighbor.old_paths[i];
+                agents[a].path.swap(neighbor.old_paths[i]);
                 path_table.insertPath(agents[a].id, agents[a].path);
                 ++p2;
             }
@@ -415,7 +453,224 @@ bool LNS::runPP()
         return false;
     }
 }
-bool LNS::runPPS(){
+void LNS::runInParallel()
+{
+    ConcurrentPathTable concurrent_path_table(instance.map_size);
+    for (const auto& agent : agents)
+        concurrent_path_table.insertPath(agent.id, agent.path);
+    shared_path_table = &concurrent_path_table;
+    in_repair.assign(agents.size(), false);
+    num_of_running_repairs = 0;
+    vector<std::thread> workers;
+    workers.reserve(num_of_threads);
+    for (int i = 0; i < num_of_threads; i++)
+        workers.emplace_back(&LNS::runWorker, this, i);
+    for (auto& worker : workers)
+        worker.join();
+    shared_path_table = nullptr;
+    if (screen >= 1)
+        cout << "Parallel LNS with " << num_of_threads << " threads: "
+             << "committed repairs = " << num_of_committed_repairs << ", "
+             << "rejected repairs = " << num_of_rejected_repairs << endl;
+}
+
+void LNS::runWorker(int worker_id)
+{
+    std::unique_lock<std::mutex> lock(lns_mutex);
+    LNSWorker worker;
+    worker.in_neighbor.assign(agents.size(), false);
+    std::seed_seq seeds{instance.getRandomSeed(), worker_id};
+    worker.random_generator.seed(seeds);
+    while (true)
+    {
+        auto iteration_start = Time::now();
+        runtime = ((fsec)(iteration_start - start_time)).count();
+        if (runtime >= time_limit or iteration_stats.size() + num_of_running_repairs > num_of_iterations)
+            break;
+        if (screen >= 1)
+            validateSolution();
+        if (ALNS)
+            chooseDestroyHeuristicbyALNS();
+
+        bool succ;
+        switch (destroy_strategy)
+        {
+            case RANDOMWALK:
+                succ = generateNeighborByRandomWalk();
+                break;
+            case INTERSECTION:
+                succ = generateNeighborByIntersection();
+                break;
+            case RANDOMAGENTS:
+                succ = generateNeighborRandomly();
+                break;
+            default:
+                cerr << "Wrong neighbor generation strategy" << endl;
+                exit(-1);
+        }
+        // skip the agents that are being replanned by other workers
+        auto& nb = worker.neighbor;
+        nb.agents.clear();
+        for (int a : neighbor.agents)
+        {
+            if (!in_repair[a])
+                nb.agents.push_back(a);
+        }
+        if (!succ) // let the other workers commit before trying again
+        {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            continue;
+        }
+        if (nb.agents.empty()) // all the agents are being replanned by other workers, so wait until one of them finishes
+        {
+            repair_finished.wait(lock);
+            continue;
+        }
+
+        // store the neighbor information
+        worker.selected_neighbor = selected_neighbor;
+        nb.old_sum_of_costs = 0;
+        for (int a : nb.agents)
+        {
+            in_repair[a] = true;
+            nb.old_sum_of_costs += (int)agents[a].path.size() - 1;
+        }
+        double T = min(time_limit - runtime, adaptive_replan_time ?
+                                             replan_time_limits.get((int)nb.agents.size()) : replan_time_limit);
+        num_of_running_repairs++; // reserve the iteration, so that the other workers do not exceed num_of_iterations
+        lock.unlock();
+
+        for (int a : nb.agents)
+            worker.in_neighbor[a] = true;
+        auto replan_start = Time::now();
+        succ = runPP(worker, PathTableView(*shared_path_table, worker.in_neighbor), T);
+        double replan_runtime = ((fsec)(Time::now() - replan_start)).count();
+        for (int a : nb.agents)
+            worker.in_neighbor[a] = false;
+
+        lock.lock();
+        num_of_running_repairs--;
+        for (int a : nb.agents)
+            in_repair[a] = false;
+        repair_finished.notify_all();
+        if (!succ)
+            num_of_failures++;
+        else if (!commitRepair(worker))
+        {
+            num_of_rejected_repairs++;
+            nb.sum_of_costs = nb.old_sum_of_costs;
+        }
+
+        if (adaptive_replan_time)
+            replan_time_limits.update((int)nb.agents.size(), succ, replan_runtime);
+        if (ALNS) // update destroy heuristics
+            updateDestroyWeights(worker.selected_neighbor, nb, iteration_start);
+        runtime = ((fsec)(Time::now() - start_time)).count();
+        sum_of_costs += nb.sum_of_costs - nb.old_sum_of_costs;
+        if (screen >= 1)
+            cout << "Iteration " << iteration_stats.size() << ", "
+                 << "worker " << worker_id << ", "
+                 << "group size = " << nb.agents.size() << ", "
+                 << "solution cost = " << sum_of_costs << ", "
+                 << "remaining time = " << time_limit - runtime << endl;
+        iteration_stats.emplace_back(nb.agents.size(), sum_of_costs, runtime, replan_algo_name);
+    }
+}
+
+// replan the neighbor of the worker by PP against the given path table, which must not contain the neighbor
+bool LNS::runPP(LNSWorker& worker, const ReadOnlyPathTable& path_table, double T, const std::atomic<bool>* stop_flag)
+{
+    auto& nb = worker.neighbor;
+    vector<int> order(nb.agents.size());
+    for (int i = 0; i < (int)order.size(); i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), worker.random_generator);
+    worker.new_paths.resize(nb.agents.size());
+    nb.sum_of_costs = 0;
+    int lowerbound = 0; // the sum of the distances of the agents that have not been replanned
+    for (int id : nb.agents)
+        lowerbound += agents[id].path_planner->my_heuristic[agents[id].path_planner->start_location];
+    auto time = Time::now();
+    ConstraintTable constraint_table(instance.num_of_cols, instance.map_size, &path_table);
+    auto p = order.begin();
+    while (p != order.end() && ((fsec)(Time::now() - time)).count() < T &&
+           (stop_flag == nullptr || !*stop_flag))
+    {
+        int id = nb.agents[*p];
+        auto& path = worker.new_paths[*p];
+        lowerbound -= agents[id].path_planner->my_heuristic[agents[id].path_planner->start_location];
+        agents[id].path_planner->findPath(constraint_table, path, nb.old_sum_of_costs - 1 - nb.sum_of_costs - lowerbound);
+        if (path.empty()) break;
+        nb.sum_of_costs += (int)path.size() - 1;
+        constraint_table.insert2CT(path); // the agents later in the order avoid this path
+        ++p;
+    }
+    bool succ = (p == order.end());
+    if (!succ)
+        nb.sum_of_costs = nb.old_sum_of_costs;
+    return succ;
+}
+
+// commit the new paths of the worker to path_table and shared_path_table.
+// As other workers may have committed repairs since the worker started,
+// the new paths are accepted only if they do not collide with the current paths of the other agents.
+bool LNS::commitRepair(LNSWorker& worker)
+{
+    const auto& nb = worker.neighbor;
+    for (int a : nb.agents)
+        path_table.deletePath(a, agents[a].path);
+    for (int i = 0; i < (int)nb.agents.size(); i++)
+    {
+        if (path_table.hasCollisions(worker.new_paths[i])) // roll back
+        {
+            for (int j = 0; j < i; j++)
+                path_table.deletePath(nb.agents[j], worker.new_paths[j]);
+            for (int a : nb.agents)
+                path_table.insertPath(a, agents[a].path);
+            return false;
+        }
+        path_table.insertPath(nb.agents[i], worker.new_paths[i]);
+    }
+    for (int a : nb.agents)
+        shared_path_table->deletePath(a, agents[a].path);
+    for (int i = 0; i < (int)nb.agents.size(); i++)
+    {
+        shared_path_table->insertPath(nb.agents[i], worker.new_paths[i]);
+        agents[nb.agents[i]].path.swap(worker.new_paths[i]);
+    }
+    num_of_committed_repairs++;
+    return true;
+}
+
+bool LNS::runPPS()
+{
+    vector<Path> paths(agents.size());
+    bool result = runPPS(paths, nullptr);
+    if (result)
+        acceptInitialSolution(paths);
+    return result;
+}
+bool LNS::runPIBT()
+{
+    vector<Path> paths(agents.size());
+    std::mt19937 random_generator(rand());
+    bool result = runPIBT(paths, random_generator, nullptr);
+    if (result)
+        acceptInitialSolution(paths);
+    return result;
+}
+bool LNS::runWinPIBT()
+{
+    vector<Path> paths(agents.size());
+    std::mt19937 random_generator(rand());
+    bool result = runWinPIBT(paths, random_generator, nullptr);
+    if (result)
+        acceptInitialSolution(paths);
+    return result;
+}
+bool LNS::runPPS(vector<Path>& paths, const std::atomic<bool>* stop_flag){
     auto shuffled_agents = neighbor.agents;
     std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
 
@@ -425,31 +680,54 @@ bool LNS::runPPS(){
     // seed for solver
     auto* MT_S = new std::mt19937(0);
     PPS solver(&P,MT_S);
-    solver.setTimeLimit(time_limit);
+    solver.setTimeLimit(time_limit - ((fsec)(Time::now() - start_time)).count());
+    solver.setStopFlag(stop_flag);
 //    solver.WarshallFloyd();
     bool result = solver.solve();
     if (result)
-        updatePIBTResult(P.getA(),shuffled_agents);
+        updatePIBTResult(P.getA(),shuffled_agents,paths);
     return result;
 }
-bool LNS::runPIBT(){
+bool LNS::runPP(vector<Path>& paths, const vector< std::unique_ptr<SingleAgentSolver> >& solvers,
+                std::mt19937& random_generator, const std::atomic<bool>* stop_flag)
+{
+    vector<int> order(neighbor.agents.size());
+    for (int i = 0; i < (int)order.size(); i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), random_generator);
+    PathTable path_table(instance.map_size, true);
+    ConstraintTable constraint_table(instance.num_of_cols, instance.map_size, &path_table);
+    for (int i : order)
+    {
+        if (stop_flag != nullptr && *stop_flag)
+            return false;
+        int id = neighbor.agents[i];
+        solvers[i]->findPath(constraint_table, paths[id]);
+        if (paths[id].empty())
+            return false;
+        path_table.insertPath(id, paths[id]);
+    }
+    return true;
+}
+bool LNS::runPIBT(vector<Path>& paths, std::mt19937& random_generator, const std::atomic<bool>* stop_flag){
     auto shuffled_agents = neighbor.agents;
-     std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+    std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), random_generator);
 
     MAPF P = preparePIBTProblem(shuffled_agents);
 
     // seed for solver
     auto MT_S = new std::mt19937(0);
     PIBT solver(&P,MT_S);
-    solver.setTimeLimit(time_limit);
+    solver.setTimeLimit(time_limit - ((fsec)(Time::now() - start_time)).count());
+    solver.setStopFlag(stop_flag);
     bool result = solver.solve();
     if (result)
-        updatePIBTResult(P.getA(),shuffled_agents);
+        updatePIBTResult(P.getA(),shuffled_agents,paths);
     return result;
 }
-bool LNS::runWinPIBT(){
+bool LNS::runWinPIBT(vector<Path>& paths, std::mt19937& random_generator, const std::atomic<bool>* stop_flag){
     auto shuffled_agents = neighbor.agents;
-    std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+    std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), random_generator);
 
     MAPF P = preparePIBTProblem(shuffled_agents);
     P.setTimestepLimit(pipp_option.timestepLimit);
@@ -457,20 +735,172 @@ bool LNS::runWinPIBT(){
     // seed for solver
     auto MT_S = new std::mt19937(0);
     winPIBT solver(&P,pipp_option.windowSize,pipp_option.winPIBTSoft,MT_S);
-    solver.setTimeLimit(time_limit);
+    solver.setTimeLimit(time_limit - ((fsec)(Time::now() - start_time)).count());
+    solver.setStopFlag(stop_flag);
     bool result = solver.solve();
     if (result)
-        updatePIBTResult(P.getA(),shuffled_agents);
+        updatePIBTResult(P.getA(),shuffled_agents,paths);
     return result;
 }
 
+// use the given paths (indexed by agent ids) as the initial solution
+void LNS::acceptInitialSolution(vector<Path>& paths)
+{
+    neighbor.sum_of_costs = 0;
+    for (int i : neighbor.agents)
+    {
+        agents[i].path = std::move(paths[i]);
+        path_table.insertPath(agents[i].id, agents[i].path);
+        neighbor.sum_of_costs += (int)agents[i].path.size() - 1;
+    }
+}
+
+void LNS::createSolvers(vector< std::unique_ptr<SingleAgentSolver> >& solvers) const
+{
+    solvers.clear();
+    solvers.reserve(neighbor.agents.size());
+    for (int i : neighbor.agents)
+    {
+        if (use_sipp)
+            solvers.emplace_back(new SIPP(instance, i));
+        else
+            solvers.emplace_back(new SpaceTimeAStar(instance, i));
+    }
+}
+
+bool LNS::runPortfolio()
+{
+    // stops the other members once a solution is found or the time limit is reached
+    std::atomic<bool> stop(false);
+    auto deadline = start_time + std::chrono::duration_cast<Time::duration>(fsec(time_limit));
+    bool solved = false;
+    int num_of_running_members = 0;
+    std::condition_variable member_finished;
+    auto finish = [&](vector<Path>& paths, const string& name)
+    {
+        std::lock_guard<std::mutex> lock(lns_mutex);
+        if (solved)
+            return false;
+        acceptInitialSolution(paths);
+        portfolio_winner = name;
+        solved = true;
+        stop = true;
+        return true;
+    };
+    // the members shuffle the agents by their own generators, as rand() must not be called from several threads
+    auto member_random_generator = [&](int member)
+    {
+        std::seed_seq seeds{instance.getRandomSeed(), member};
+        return std::mt19937(seeds);
+    };
+    // run the member in a new thread, where an exception (e.g., running out of memory) only fails this member
+    auto start_member = [&](const string& name, std::function<void()> member)
+    {
+        {
+            std::lock_guard<std::mutex> lock(lns_mutex);
+            num_of_running_members++;
+        }
+        return std::thread([&, name, member]()
+        {
+            try
+            {
+                member();
+            }
+            catch (const std::exception& e)
+            {
+                if (screen >= 1)
+                    cout << "Portfolio: " << name << " failed with " << e.what() << endl;
+            }
+            std::lock_guard<std::mutex> lock(lns_mutex);
+            num_of_running_members--;
+            member_finished.notify_all();
+        });
+    };
+
+    size_t num_of_nodes = 0;
+    for (int i = 0; i < instance.map_size; i++)
+        num_of_nodes += !instance.isObstacle(i);
+    bool use_pibt = (num_of_nodes * num_of_nodes * sizeof(int) <= PORTFOLIO_PIBT_MAX_MEMORY);
+    if (!use_pibt and screen >= 1)
+        cout << "Portfolio: skip PIBT and winPIBT, as the map is too large for their distance matrices" << endl;
+    vector<std::thread> members;
+    for (int i = 0; i < PORTFOLIO_PP_RUNS; i++)
+    {
+        members.push_back(start_member("PP", [&, i]()
+        {
+            vector< std::unique_ptr<SingleAgentSolver> > solvers;
+            createSolvers(solvers);
+            vector<Path> paths(agents.size());
+            std::mt19937 random_generator = member_random_generator(i);
+            if (runPP(paths, solvers, random_generator, &stop))
+                finish(paths, "PP");
+        }));
+    }
+    members.push_back(start_member("EECBS", [&]()
+    {
+        vector< std::unique_ptr<SingleAgentSolver> > solvers;
+        createSolvers(solvers);
+        vector<SingleAgentSolver*> search_engines;
+        search_engines.reserve(solvers.size());
+        for (const auto& solver : solvers)
+            search_engines.push_back(solver.get());
+        ECBS ecbs(search_engines, screen - 1, nullptr);
+        setUpEECBS(ecbs);
+        ecbs.setStopFlag(&stop);
+        ecbs.setDeadline(deadline);
+        if (ecbs.solve(MAX_TIMESTEP, 0)) // only the deadline limits the time, as the other members use CPU time too
+        {
+            vector<Path> paths(agents.size());
+            for (int j = 0; j < (int)neighbor.agents.size(); j++)
+                paths[neighbor.agents[j]] = *ecbs.paths[j];
+            if (finish(paths, "EECBS"))
+                sum_of_costs_lowerbound = ecbs.getLowerBound();
+        }
+    }));
+    if (use_pibt)
+    {
+        members.push_back(start_member("PIBT", [&]()
+        {
+            vector<Path> paths(agents.size());
+            std::mt19937 random_generator = member_random_generator(PORTFOLIO_PP_RUNS);
+            if (runPIBT(paths, random_generator, &stop))
+                finish(paths, "PIBT");
+        }));
+        members.push_back(start_member("winPIBT", [&]()
+        {
+            vector<Path> paths(agents.size());
+            std::mt19937 random_generator = member_random_generator(PORTFOLIO_PP_RUNS + 1);
+            if (runWinPIBT(paths, random_generator, &stop))
+                finish(paths, "winPIBT");
+        }));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(lns_mutex);
+        member_finished.wait_until(lock, deadline, [&]() { return solved or num_of_running_members == 0; });
+    }
+    stop = true;
+    for (auto& member : members)
+        member.join();
+    if (screen >= 1 and solved)
+        cout << "Portfolio: initial solution found by " << portfolio_winner << endl;
+    return solved;
+}
+
 MAPF LNS::preparePIBTProblem(vector<int>& shuffled_agents){
 
     // seed for problem and graph
     auto MT_PG = new std::mt19937(0);
 
 //    Graph* G = new SimpleGrid(instance);
-    Graph* G = new SimpleGrid(instance.getMapFile());
+    Graph* G;
+    {
+        // the portfolio builds the problems of PIBT and winPIBT concurrently, and SimpleGrid parses the map
+        // with std::regex, whose lazily filled locale caches are not safe to fill from two threads at once
+        static std::mutex map_file_mutex;
+        std::lock_guard<std::mutex> lock(map_file_mutex);
+        G = new SimpleGrid(instance.getMapFile());
+    }
 
     std::vector<Task*> T;
     PIBT_Agents A;
@@ -478,7 +908,7 @@ MAPF LNS::preparePIBTProblem(vector<int>& shuffled_agents){
     for (int i : shuffled_agents){
         assert(G->existNode(agents[i].path_planner->start_location));
         assert(G->existNode(agents[i].path_planner->goal_location));
-        auto a = new PIBT_Agent(G->getNode( agents[i].path_planner->start_location));
+        auto a = new PIBT_Agent(G->getNode( agents[i].path_planner->start_location), A.size());
 
 //        PIBT_Agent* a = new PIBT_Agent(G->getNode( agents[i].path_planner.start_location));
         A.push_back(a);
@@ -495,56 +925,144 @@ MAPF LNS::preparePIBTProblem(vector<int>& shuffled_agents){
 
 }
 
-void LNS::updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents){
-    int soc = 0;
+void LNS::updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents, vector<Path>& paths){
     for (int i=0; i<A.size();i++){
         int a_id = shuffled_agents[i];
+        auto& path = paths[a_id];
 
-        agents[a_id].path.resize(A[i]->getHist().size());
+        path.resize(A[i]->getHist().size());
         int last_goal_visit = 0;
         if(screen>=2)
             std::cout<<A[i]->logStr()<<std::endl;
         for (int n_index = 0; n_index < A[i]->getHist().size(); n_index++){
             auto n = A[i]->getHist()[n_index];
-            agents[a_id].path[n_index] = PathEntry(n->v->getId());
+            path[n_index] = PathEntry(n->v->getId());
 
             //record the last time agent reach the goal from a non-goal vertex.
             if(agents[a_id].path_planner->goal_location == n->v->getId()
                 && n_index - 1>=0
-                && agents[a_id].path_planner->goal_location !=  agents[a_id].path[n_index - 1].location)
+                && agents[a_id].path_planner->goal_location !=  path[n_index - 1].location)
                 last_goal_visit = n_index;
 
         }
         //resize to last goal visit time
-        agents[a_id].path.resize(last_goal_visit + 1);
+        path.resize(last_goal_visit + 1);
         if(screen>=2)
-            std::cout<<" Length: "<< agents[a_id].path.size() <<std::endl;
+            std::cout<<" Length: "<< path.size() <<std::endl;
         if(screen>=5){
             cout <<"Agent "<<a_id<<":";
-            for (auto loc : agents[a_id].path){
+            for (auto loc : path){
                 cout <<loc.location<<",";
             }
             cout<<endl;
         }
-        path_table.insertPath(agents[a_id].id, agents[a_id].path);
-        soc += (int)agents[a_id].path.size()-1;
     }
-
-    neighbor.sum_of_costs =soc;
 }
 
 void LNS::chooseDestroyHeuristicbyALNS()
 {
-    rouletteWheel();
-    switch (selected_neighbor)
+    auto untried = std::find_if(arms.begin(), arms.end(), [](const LNSArm& arm) { return arm.num_of_selections == 0; });
+    if (adaptive_neighbor_size and untried != arms.end())
+        selected_neighbor = (int)(untried - arms.begin());
+    else
+        rouletteWheel();
+    destroy_strategy = arms[selected_neighbor].heuristic;
+    neighbor_size = arms[selected_neighbor].neighbor_size;
+}
+
+void LNS::updateDestroyWeights(int arm, const Neighbor& nb, const high_resolution_clock::time_point& iteration_start)
+{
+    double iteration_runtime = ((fsec)(Time::now() - iteration_start)).count();
+    auto& stats = arms[arm];
+    int cost_reduction = max(nb.old_sum_of_costs - nb.sum_of_costs, 0);
+    stats.num_of_selections++;
+    stats.runtime += iteration_runtime;
+    stats.cost_reduction += cost_reduction;
+    if (cost_reduction > 0)
+        stats.num_of_improvements++;
+    if (adaptive_neighbor_size)
+    {
+        stats.recent_cost_reduction = (1 - reaction_factor) * stats.recent_cost_reduction + cost_reduction;
+        stats.recent_runtime = (1 - reaction_factor) * stats.recent_runtime + iteration_runtime;
+        double total_cost_reduction = 0, total_runtime = 0;
+        for (const auto& other : arms)
+        {
+            total_cost_reduction += other.recent_cost_reduction;
+            total_runtime += other.recent_runtime;
+        }
+        if (total_cost_reduction == 0 or total_runtime == 0) // no information yet
+            return;
+        double mean_rate = total_cost_reduction / total_runtime;
+        for (int i = 0; i < (int)arms.size(); i++)
+        {
+            if (arms[i].recent_runtime > 0)
+                destroy_weights[i] = max(arms[i].recent_cost_reduction / arms[i].recent_runtime / mean_rate,
+                                         MIN_ARM_WEIGHT);
+        }
+    }
+    else if (cost_reduction > 0)
+        destroy_weights[arm] = reaction_factor * cost_reduction / nb.agents.size()
+                               + (1 - reaction_factor) * destroy_weights[arm];
+    else
+        destroy_weights[arm] = (1 - decay_factor) * destroy_weights[arm];
+}
+
+void LNS::printArmStats() const
+{
+    const string heuristic_names[DESTORY_COUNT] = {"Random", "RandomWalk", "Intersection"}; // in the order of destroy_heuristic
+    double sum_of_weights = 0;
+    for (auto weight : destroy_weights)
+        sum_of_weights += weight;
+    cout << "ALNS arms (destroy heuristic, neighbor size): "
+         << "selections, improvements, cost reduction, runtime, cost reduction per second, final weight" << endl;
+    for (int i = 0; i < (int)arms.size(); i++)
     {
-        case 0 : destroy_strategy = RANDOMWALK; break;
-        case 1 : destroy_strategy = INTERSECTION; break;
-        case 2 : destroy_strategy = RANDOMAGENTS; break;
-        default : cerr << "ERROR" << endl; exit(-1);
+        const auto& arm = arms[i];
+        cout << "\t" << heuristic_names[arm.heuristic] << ", " << arm.neighbor_size << ": "
+             << arm.num_of_selections << ", " << arm.num_of_improvements << ", " << arm.cost_reduction << ", "
+             << arm.runtime << ", " << (arm.runtime > 0 ? arm.cost_reduction / arm.runtime : 0) << ", "
+             << destroy_weights[i] / sum_of_weights << endl;
     }
 }
 
+const int ReplanTimeLimits::MIN_SAMPLES;
+const int ReplanTimeLimits::MAX_SAMPLES;
+
+void ReplanTimeLimits::update(int neighbor_size, bool succ, double runtime)
+{
+    auto it = limits.find(neighbor_size);
+    if (it == limits.end())
+    {
+        it = limits.emplace(neighbor_size, Limit()).first;
+        it->second.time_limit = max_time_limit;
+    }
+    auto& limit = it->second;
+    if (succ)
+        limit.runtimes.push_back(runtime);
+    else if (runtime >= limit.time_limit)
+    {
+        limit.runtimes.push_back(limit.time_limit);
+        limit.num_of_timeouts++;
+    }
+    else // failed for other reasons than the time limit, e.g., the new paths are not better
+        return;
+    if ((int)limit.runtimes.size() > MAX_SAMPLES)
+        limit.runtimes.pop_front();
+    if ((int)limit.runtimes.size() < MIN_SAMPLES)
+        return;
+    vector<double> runtimes(limit.runtimes.begin(), limit.runtimes.end());
+    auto percentile = runtimes.begin() + (int)(0.95 * (runtimes.size() - 1));
+    std::nth_element(runtimes.begin(), percentile, runtimes.end());
+    limit.time_limit = min(max_time_limit, 2 * *percentile);
+}
+
+void ReplanTimeLimits::print() const
+{
+    cout << "Replan time limits (neighbor size): time limit, timeouts" << endl;
+    for (const auto& limit : limits)
+        cout << "\t" << limit.first << ": " << limit.second.time_limit << ", " << limit.second.num_of_timeouts << endl;
+}
+
 bool LNS::generateNeighborByIntersection()
 {
     if (intersections.empty())
@@ -596,6 +1114,18 @@ bool LNS::generateNeighborByIntersection()
         cout << "Generate " << neighbor.agents.size() << " neighbors by intersection " << location << endl;
     return true;
 }
+bool LNS::generateNeighborRandomly()
+{
+    neighbor.agents.resize(agents.size());
+    for (int i = 0; i < (int)agents.size(); i++)
+        neighbor.agents[i] = i;
+    if (neighbor.agents.size() > neighbor_size)
+    {
+        std::random_shuffle(neighbor.agents.begin(), neighbor.agents.end());
+        neighbor.agents.resize(neighbor_size);
+    }
+    return true;
+}
 bool LNS::generateNeighborByRandomWalk()
 {
     if (neighbor_size >= (int)agents.size())
@@ -691,8 +1221,8 @@ void LNS::randomWalk(int agent_id, int start_location, int start_timestep,
     int loc = start_location;
     for (int t = start_timestep; t < upperbound; t++)
     {
-        auto next_locs = instance.getNeighbors(loc);
-        next_locs.push_back(loc);
+        auto next_locations = instance.getNextLocations(loc);
+        vector<int> next_locs(next_locations.begin(), next_locations.end()); // the moves that have not been tried
         while (!next_locs.empty())
         {
             int step = rand() % next_locs.size();
@@ -14,3 +14,7 @@ Node::Node(int _id) : id(_id), index(cntIndex) {
   ++cntIndex;
   pos = Vec2f(0, 0);
 }
+
+Node::Node(int _id, int _index) : id(_id), index(_index) {
+  pos = Vec2f(0, 0);
+}
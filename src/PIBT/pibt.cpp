@@ -52,6 +52,9 @@ bool PIBT::solve() {
       if(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit){
           break;
       }
+      if(stopped()){
+          break;
+      }
   }
 
   solveEnd();
@@ -28,6 +28,14 @@ PIBT_Agent::PIBT_Agent(Node* _v) : id(cntId) {
     updated = false;
 }
 
+PIBT_Agent::PIBT_Agent(Node* _v, int _id) : id(_id) {
+    g = nullptr;
+    tau = nullptr;
+    v = nullptr;
+    setNode(_v);
+    updated = false;
+}
+
 PIBT_Agent::~PIBT_Agent() {
     for (auto s : hist) delete s;
     hist.clear();
@@ -12,8 +12,6 @@
 #include "pps.h"
 #include "util.h"
 
-int PPS::s_uuid = 0;
-
 PPS::PPS(Problem* _P) : Solver(_P) {
   init();
 }
@@ -55,6 +53,9 @@ bool PPS::solve() {
       if(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit){
           break;
       }
+      if(stopped()){
+          break;
+      }
   }
 
   solveEnd();
@@ -38,7 +38,8 @@ void Solver::solveEnd() {
   elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>
     (endT-startT).count();
 
-  // check consistency
+  // check consistency, which takes O(agents^2 * timesteps), so skip the unsolved problems whose paths are discarded
+  if (!P->isSolved()) return;
   // 1. create path
   std::vector<Nodes> paths;
   for (auto a : A) {
@@ -86,6 +86,9 @@ bool winPIBT::solve() {
     if(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit){
       break;
     }
+    if(stopped()){
+      break;
+    }
 
     ++t;
   }
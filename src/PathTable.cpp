@@ -1,70 +1,215 @@
 #include "PathTable.h"
 
-void PathTable::insertPath(int agent_id, const Path& path)
+const int PathTable::MIN_ROW_CAPACITY;
+
+void PathTable::reset()
 {
-    if (path.empty())
+    rows.assign(rows.size(), Row());
+    intervals.clear(); // keep the capacity for the next paths
+    num_of_unused_intervals = 0;
+    for (auto& location_safe_intervals : safe_intervals)
+        location_safe_intervals.clear();
+    goal_time_counter.clear();
+    makespan = 0;
+}
+
+void PathTable::reserve(Row& row, int size)
+{
+    if (size <= row.capacity)
         return;
-    for (int t = 0; t < (int)path.size(); t++)
+    // move the row to the end of intervals
+    int capacity = max(max(2 * row.capacity, size), (int) MIN_ROW_CAPACITY);
+    int offset = (int) intervals.size();
+    intervals.resize(intervals.size() + capacity);
+    std::copy(intervals.begin() + row.offset, intervals.begin() + row.offset + row.size, intervals.begin() + offset);
+    num_of_unused_intervals += row.capacity;
+    row.offset = offset;
+    row.capacity = capacity;
+}
+
+void PathTable::insertInterval(int location, const AgentInterval& interval)
+{
+    auto& row = rows[location];
+    auto first = intervals.begin() + row.offset, last = first + row.size;
+    // the intervals [i, j) overlap the new interval. This only happens when the table stores colliding paths
+    // (e.g., in InitLNS::runGCBS), and then the new interval overwrites them, as later paths overwrite cells.
+    int i = (int) (std::upper_bound(first, last, interval.t_min,
+            [](int t, const AgentInterval& other) { return t < other.t_max; }) - first);
+    int j = (int) (std::lower_bound(first + i, last, interval.t_max,
+            [](const AgentInterval& other, int t) { return other.t_min < t; }) - first);
+    AgentInterval replacement[3];
+    int n = 0;
+    if (i < j and first[i].t_min < interval.t_min)
+        replacement[n++] = AgentInterval(first[i].t_min, interval.t_min, first[i].agent);
+    replacement[n++] = interval;
+    if (i < j and first[j - 1].t_max > interval.t_max)
+        replacement[n++] = AgentInterval(interval.t_max, first[j - 1].t_max, first[j - 1].agent);
+
+    int size = row.size + n - (j - i);
+    reserve(row, size);
+    first = intervals.begin() + row.offset;
+    if (n <= j - i)
+        std::copy(first + j, first + row.size, first + i + n);
+    else
+        std::copy_backward(first + j, first + row.size, first + size);
+    std::copy(replacement, replacement + n, first + i);
+    row.size = size;
+}
+
+void PathTable::deleteInterval(int location, const AgentInterval& interval)
+{
+    auto& row = rows[location];
+    auto first = intervals.begin() + row.offset;
+    auto last = first + row.size;
+    auto it = std::lower_bound(first, last, interval.t_min,
+                               [](const AgentInterval& other, int t) { return other.t_min < t; });
+    if (it != last and it->t_min == interval.t_min and it->t_max == interval.t_max and it->agent == interval.agent)
     {
-        if (table[path[t].location].size() <= t)
-            table[path[t].location].resize(t + 1, NO_AGENT);
-        // assert(table[path[t].location][t] == NO_AGENT);
-        table[path[t].location][t] = agent_id;
+        std::copy(it + 1, last, it);
+        row.size--;
+        return;
     }
-    assert(goals[path.back().location] == MAX_TIMESTEP);
-    goals[path.back().location] = (int) path.size() - 1;
-    makespan = max(makespan, (int) path.size() - 1);
+    // the interval has been partly or fully overwritten by a colliding path (see insertInterval),
+    // so remove whatever is left of it, i.e., the intervals of the agent within [t_min, t_max)
+    it = std::upper_bound(first, last, interval.t_min,
+                          [](int t, const AgentInterval& other) { return t < other.t_max; });
+    auto end = std::lower_bound(it, last, interval.t_max,
+                                [](const AgentInterval& other, int t) { return other.t_min < t; });
+    auto new_end = std::remove_if(it, end, [&interval](const AgentInterval& other)
+            { return other.agent == interval.agent; });
+    std::copy(end, last, new_end);
+    row.size -= (int) (end - new_end);
 }
 
-void PathTable::deletePath(int agent_id, const Path& path)
+// remove the intervals left behind by the moved rows once they take up half of the array
+void PathTable::compact()
 {
-    if (path.empty())
+    if (num_of_unused_intervals * 2 < (int) intervals.size())
+        return;
+    vector<AgentInterval> new_intervals;
+    new_intervals.reserve(intervals.size() - num_of_unused_intervals);
+    for (auto& row : rows)
+    {
+        new_intervals.insert(new_intervals.end(), intervals.begin() + row.offset,
+                             intervals.begin() + row.offset + row.capacity);
+        row.offset = (int) new_intervals.size() - row.capacity;
+    }
+    intervals.swap(new_intervals);
+    num_of_unused_intervals = 0;
+}
+
+void PathTable::updateSafeIntervals(const Path& path)
+{
+    if (safe_intervals.empty())
         return;
     for (int t = 0; t < (int)path.size(); t++)
     {
-        assert(table[path[t].location].size() > t && table[path[t].location][t] == agent_id);
-        table[path[t].location][t] = NO_AGENT;
+        if (t == 0 or path[t].location != path[t - 1].location) // once per wait run
+            updateSafeIntervals(path[t].location);
     }
-    goals[path.back().location] = MAX_TIMESTEP;
-    if (makespan == (int) path.size() - 1) // re-compute makespan
+}
+
+void PathTable::updateSafeIntervals(int location)
+{
+    const auto& row = rows[location];
+    auto& location_safe_intervals = safe_intervals[location];
+    location_safe_intervals.clear();
+    int t_max = min(row.goal_time, MAX_TIMESTEP); // the location is blocked after the goal time
+    int t = 0;
+    for (auto it = intervals.begin() + row.offset; it != intervals.begin() + row.offset + row.size; ++it)
     {
-        makespan = 0;
-        for (int time : goals)
-        {
-            if (time < MAX_TIMESTEP && time > makespan)
-                makespan = time;
-        }
+        if (it->t_min >= t_max)
+            break;
+        if (t < it->t_min)
+            location_safe_intervals.emplace_back(t, it->t_min, false);
+        t = max(t, it->t_max);
+    }
+    if (t < t_max)
+        location_safe_intervals.emplace_back(t, t_max, false);
+}
+
+const vector<Interval>* PathTable::getSafeIntervals(int location) const
+{
+    static const vector<Interval> free_intervals(1, Interval(0, MAX_TIMESTEP, false));
+    if (empty())
+        return &free_intervals;
+    const auto& row = rows[location];
+    if (row.size == 0 and row.goal_time == MAX_TIMESTEP)
+        return &free_intervals;
+    return safe_intervals.empty() ? nullptr : &safe_intervals[location];
+}
 
+void PathTable::insertPath(int agent_id, const Path& path)
+{
+    if (path.empty())
+        return;
+    for (int t = 0; t < (int)path.size();)
+    {
+        int t_min = t++;
+        while (t < (int)path.size() and path[t].location == path[t_min].location) // wait actions
+            t++;
+        insertInterval(path[t_min].location, AgentInterval(t_min, t, agent_id));
     }
+    compact();
+    assert(rows[path.back().location].goal_time == MAX_TIMESTEP);
+    rows[path.back().location].goal_time = (int) path.size() - 1;
+    goal_time_counter.insert((int) path.size() - 1);
+    makespan = goal_time_counter.getMakespan();
+    updateSafeIntervals(path);
 }
 
-bool PathTable::constrained(int from, int to, int to_time) const
+void PathTable::deletePath(int agent_id, const Path& path)
 {
-    if (!table.empty())
+    if (path.empty())
+        return;
+    for (int t = 0; t < (int)path.size();)
     {
-        if (table[to].size() > to_time && table[to][to_time] != NO_AGENT)
-            return true;  // vertex conflict with agent table[to][to_time]
-        else if (table[to].size() >= to_time && table[from].size() > to_time && !table[to].empty() &&
-                 table[to][to_time - 1] != NO_AGENT && table[from][to_time] == table[to][to_time - 1])
-            return true;  // edge conflict with agent table[to][to_time - 1]
+        int t_min = t++;
+        while (t < (int)path.size() and path[t].location == path[t_min].location)
+            t++;
+        deleteInterval(path[t_min].location, AgentInterval(t_min, t, agent_id));
     }
-    if (!goals.empty())
+    rows[path.back().location].goal_time = MAX_TIMESTEP;
+    goal_time_counter.erase((int) path.size() - 1);
+    makespan = goal_time_counter.getMakespan();
+    updateSafeIntervals(path);
+}
+
+bool PathTable::constrained(int from, int to, int to_time) const
+{
+    return !empty() and constrainedByCells(*this, from, to, to_time);
+}
+
+void PathTable::getIntervals(int location, vector<AgentInterval>& intervals) const
+{
+    if (empty())
+        return;
+    const auto& row = rows[location];
+    intervals.insert(intervals.end(), this->intervals.begin() + row.offset,
+                     this->intervals.begin() + row.offset + row.size);
+}
+
+bool PathTable::hasCollisions(const Path& path) const
+{
+    for (int t = 1; t < (int)path.size(); t++)
     {
-        if (goals[to] <= to_time)
-            return true; // target conflict
+        if (constrained(path[t - 1].location, path[t].location, t))
+            return true;
     }
-    return false;
+    // target conflict: another agent visits the goal location after the path ends
+    return getHoldingTime(path.back().location, (int)path.size() - 1) > (int)path.size() - 1;
 }
 
 void PathTable::getConflictingAgents(int agent_id, set<int>& conflicting_agents, int from, int to, int to_time) const
 {
-    if (table.empty())
+    if (empty())
         return;
-    if (table[to].size() > to_time && table[to][to_time] != NO_AGENT)
-        conflicting_agents.insert(table[to][to_time]); // vertex conflict
-    if (table[to].size() >= to_time && table[from].size() > to_time &&
-        table[to][to_time - 1] != NO_AGENT && table[from][to_time] == table[to][to_time - 1])
-        conflicting_agents.insert(table[from][to_time]); // edge conflict
+    auto agent = getAgent(to, to_time);
+    if (agent != NO_AGENT)
+        conflicting_agents.insert(agent); // vertex conflict
+    agent = getAgent(to, to_time - 1);
+    if (agent != NO_AGENT && getAgent(from, to_time) == agent)
+        conflicting_agents.insert(agent); // edge conflict
     // TODO: collect target conflicts as well.
 }
 
@@ -72,8 +217,9 @@ void PathTable::get_agents(set<int>& conflicting_agents, int loc) const
 {
     if (loc < 0)
         return;
-    for (auto agent : table[loc])
+    for (int t = 0; t < getLength(loc); t++)
     {
+        auto agent = getAgent(loc, t);
         if (agent >= 0)
             conflicting_agents.insert(agent);
     }
@@ -81,28 +227,28 @@ void PathTable::get_agents(set<int>& conflicting_agents, int loc) const
 
 void PathTable::get_agents(set<int>& conflicting_agents, int neighbor_size, int loc) const
 {
-    if (loc < 0 || table[loc].empty())
+    if (loc < 0 || getLength(loc) == 0)
         return;
-    int t_max = (int) table[loc].size() - 1;
-    while (table[loc][t_max] == NO_AGENT && t_max > 0)
+    int t_max = getLength(loc) - 1;
+    while (getAgent(loc, t_max) == NO_AGENT && t_max > 0)
         t_max--;
     if (t_max == 0)
         return;
     int t0 = rand() % t_max;
-    if (table[loc][t0] != NO_AGENT)
-        conflicting_agents.insert(table[loc][t0]);
+    if (getAgent(loc, t0) != NO_AGENT)
+        conflicting_agents.insert(getAgent(loc, t0));
     int delta = 1;
     while (t0 - delta >= 0 || t0 + delta <= t_max)
     {
-        if (t0 - delta >= 0 && table[loc][t0 - delta] != NO_AGENT)
+        if (t0 - delta >= 0 && getAgent(loc, t0 - delta) != NO_AGENT)
         {
-            conflicting_agents.insert(table[loc][t0 - delta]);
+            conflicting_agents.insert(getAgent(loc, t0 - delta));
             if((int) conflicting_agents.size() == neighbor_size)
                 return;
         }
-        if (t0 + delta <= t_max && table[loc][t0 + delta] != NO_AGENT)
+        if (t0 + delta <= t_max && getAgent(loc, t0 + delta) != NO_AGENT)
         {
-            conflicting_agents.insert(table[loc][t0 + delta]);
+            conflicting_agents.insert(getAgent(loc, t0 + delta));
             if((int) conflicting_agents.size() == neighbor_size)
                 return;
         }
@@ -113,12 +259,9 @@ void PathTable::get_agents(set<int>& conflicting_agents, int neighbor_size, int
 // get the holding time after the earliest_timestep for a location
 int PathTable::getHoldingTime(int location, int earliest_timestep = 0) const
 {
-    if (table.empty() or (int) table[location].size() <= earliest_timestep)
+    if (empty())
         return earliest_timestep;
-    int rst = (int) table[location].size();
-    while (rst > earliest_timestep and table[location][rst - 1] == NO_AGENT)
-        rst--;
-    return rst;
+    return getHoldingTimeByCells(*this, location, earliest_timestep);
 }
 
 void PathTableWC::insertPath(int agent_id, const Path& path)
@@ -134,7 +277,9 @@ void PathTableWC::insertPath(int agent_id, const Path& path)
     }
     assert(goals[path.back().location] == MAX_TIMESTEP);
     goals[path.back().location] = (int) path.size() - 1;
-    makespan = max(makespan, (int) path.size() - 1);
+    goal_agents[path.back().location] = agent_id;
+    goal_time_counter.insert((int) path.size() - 1);
+    makespan = goal_time_counter.getMakespan();
 }
 void PathTableWC::insertPath(int agent_id)
 {
@@ -154,16 +299,9 @@ void PathTableWC::deletePath(int agent_id)
         table[path[t].location][t].remove(agent_id);
     }
     goals[path.back().location] = MAX_TIMESTEP;
-    if (makespan == (int) path.size() - 1) // re-compute makespan
-    {
-        makespan = 0;
-        for (int time : goals)
-        {
-            if (time < MAX_TIMESTEP && time > makespan)
-                makespan = time;
-        }
-
-    }
+    goal_agents[path.back().location] = NO_AGENT;
+    goal_time_counter.erase((int) path.size() - 1);
+    makespan = goal_time_counter.getMakespan();
 }
 
 int PathTableWC::getFutureNumOfCollisions(int loc, int time) const
@@ -277,4 +415,62 @@ void PathTableWC::clear()
     table.clear();
     goals.clear();
     paths.clear();
-}
\ No newline at end of file
+    goal_agents.clear();
+    goal_time_counter.clear();
+    makespan = 0;
+}
+int PathTableWCView::getFutureNumOfCollisions(int loc, int time) const
+{
+    int rst = 0;
+    if (!empty())
+    {
+        for (int t = time + 1; t < getLength(loc); t++)
+            rst += getNumOfAgents(loc, t);  // vertex conflict
+    }
+    return rst;
+}
+
+int PathTableWCView::getNumOfCollisions(int from, int to, int to_time) const
+{
+    if (empty())
+        return 0;
+    int rst = getNumOfAgents(to, to_time) + getNumOfEdgeCollisions(from, to, to_time); // vertex and edge conflicts
+    if (getGoalTime(to) < to_time)
+        rst++; // target conflict
+    return rst;
+}
+
+int PathTableWCView::getNumOfEdgeCollisions(int from, int to, int to_time) const
+{
+    int rst = 0;
+    if (!empty() && from != to && to_time > 0)
+    {
+        forEachAgent(to, to_time - 1, [&](int a1) {
+            forEachAgent(from, to_time, [&](int a2) {
+                if (a1 == a2)
+                    rst++;
+            });
+        });
+    }
+    return rst;
+}
+
+int PathTableWCView::getLastCollisionTimestep(int location) const
+{
+    if (empty())
+        return -1;
+    for (int t = getLength(location) - 1; t >= 0; t--)
+    {
+        if (getNumOfAgents(location, t) > 0)
+            return t;
+    }
+    return -1;
+}
+
+int PathTableWCView::getGoalTime(int location) const
+{
+    int agent = path_table.getGoalAgent(location);
+    if (agent == NO_AGENT or ignored[agent])
+        return overlay.getGoalTime(location);
+    return path_table.getGoalTime(location);
+}
@@ -195,19 +195,22 @@ void ReservationTable::updateSIT(int location)
         sit[location].emplace_back(0, min(constraint_table.length_max, MAX_TIMESTEP - 1) + 1, false);
     }
     // path table
-    if (constraint_table.path_table_for_CT != nullptr and !constraint_table.path_table_for_CT->table.empty())
+    const auto* path_table = constraint_table.path_table_for_CT;
+    if (path_table != nullptr and !path_table->empty())
     {
+        intervals.clear();
         if (location < constraint_table.map_size) // vertex conflict
         {
-            for (int t = 0; t < (int)constraint_table.path_table_for_CT->table[location].size(); t++)
+            path_table->getIntervals(location, intervals);
+            for (size_t i = 0; i < intervals.size();)
             {
-                if (constraint_table.path_table_for_CT->table[location][t] != NO_AGENT)
-                {
-                    insert2SIT(location, t, t+1);
-                }
+                int t_min = intervals[i].t_min, t_max = intervals[i].t_max;
+                for (i++; i < intervals.size() and intervals[i].t_min == t_max; i++)
+                    t_max = intervals[i].t_max; // merge the intervals of the agents that occupy the location one after another
+                insert2SIT(location, t_min, t_max);
             }
-            if (constraint_table.path_table_for_CT->goals[location] < MAX_TIMESTEP) // target conflict
-                insert2SIT(location, constraint_table.path_table_for_CT->goals[location], MAX_TIMESTEP + 1);
+            if (path_table->getGoalTime(location) < MAX_TIMESTEP) // target conflict
+                insert2SIT(location, path_table->getGoalTime(location), MAX_TIMESTEP + 1);
         }
         else // edge conflict
         {
@@ -215,28 +218,21 @@ void ReservationTable::updateSIT(int location)
             auto to = location % constraint_table.map_size;
             if (from != to)
             {
-                int t_max = (int) min(constraint_table.path_table_for_CT->table[from].size(),
-                                      constraint_table.path_table_for_CT->table[to].size() + 1);
-                for (int t = 1; t < t_max; t++)
+                // an agent moves from location to to location from only at the end of its interval at to
+                path_table->getIntervals(to, intervals);
+                for (const auto& interval : intervals)
                 {
-                    if (constraint_table.path_table_for_CT->table[to][t - 1] != NO_AGENT and
-                        constraint_table.path_table_for_CT->table[to][t - 1] ==
-                        constraint_table.path_table_for_CT->table[from][t])
-                    {
-                        insert2SIT(location, t, t+1);
-                    }
+                    if (path_table->getAgent(from, interval.t_max) == interval.agent)
+                        insert2SIT(location, interval.t_max, interval.t_max + 1);
                 }
             }
         }
     }
 
     // negative constraints
-    const auto& it = constraint_table.ct.find(location);
-    if (it != constraint_table.ct.end())
-    {
-        for (auto time_range : it->second)
-            insert2SIT(location, time_range.first, time_range.second);
-    }
+    auto range = constraint_table.getConstraints(location);
+    for (auto it = range.first; it != range.second; ++it)
+        insert2SIT(location, it->t_min, it->t_max);
 
     // positive constraints
     if (location < constraint_table.map_size)
@@ -252,19 +248,20 @@ void ReservationTable::updateSIT(int location)
 
     // soft path table
     if (constraint_table.path_table_for_CAT != nullptr and
-        !constraint_table.path_table_for_CAT->table.empty())
+        !constraint_table.path_table_for_CAT->empty())
     {
+        const auto& path_table = *constraint_table.path_table_for_CAT;
         if (location < constraint_table.map_size) // vertex conflict
         {
-            for (int t = 0; t < (int)constraint_table.path_table_for_CAT->table[location].size(); t++)
+            for (int t = 0; t < path_table.getLength(location); t++)
             {
-                if (!constraint_table.path_table_for_CAT->table[location][t].empty())
+                if (path_table.getNumOfAgents(location, t) > 0)
                 {
                     insertSoftConstraint2SIT(location, t, t+1);
                 }
             }
-            if (constraint_table.path_table_for_CAT->goals[location] < MAX_TIMESTEP) // target conflict
-                insertSoftConstraint2SIT(location, constraint_table.path_table_for_CAT->goals[location], MAX_TIMESTEP + 1);
+            if (path_table.getGoalTime(location) < MAX_TIMESTEP) // target conflict
+                insertSoftConstraint2SIT(location, path_table.getGoalTime(location), MAX_TIMESTEP + 1);
         }
         else // edge conflict
         {
@@ -272,25 +269,11 @@ void ReservationTable::updateSIT(int location)
             auto to = location % constraint_table.map_size;
             if (from != to)
             {
-                int t_max = (int) min(constraint_table.path_table_for_CAT->table[from].size(),
-                                      constraint_table.path_table_for_CAT->table[to].size() + 1);
+                int t_max = min(path_table.getLength(from), path_table.getLength(to) + 1);
                 for (int t = 1; t < t_max; t++)
                 {
-                    bool found = false;
-                    for (auto a1 : constraint_table.path_table_for_CAT->table[to][t - 1])
-                    {
-                        for (auto a2: constraint_table.path_table_for_CAT->table[from][t])
-                        {
-                            if (a1 == a2)
-                            {
-                                insertSoftConstraint2SIT(location, t, t+1);
-                                found = true;
-                                break;
-                            }
-                            if (found)
-                                break;
-                        }
-                    }
+                    if (path_table.hasEdgeCollisions(from, to, t))
+                        insertSoftConstraint2SIT(location, t, t+1);
                 }
             }
         }
@@ -299,27 +282,59 @@ void ReservationTable::updateSIT(int location)
     // soft constraints
     if (!constraint_table.cat.empty())
     {
-        for (auto t = 0; t < constraint_table.cat[location].size(); t++)
+        const auto& bits = constraint_table.cat[location];
+        for (int word = 0; word < (int)bits.size(); word++)
         {
-            if (constraint_table.cat[location][t])
+            for (auto rest = bits[word]; rest != 0; rest &= rest - 1) // from the lowest bit
+            {
+                int t = word * 64 + __builtin_ctzll(rest);
                 insertSoftConstraint2SIT(location, t, t + 1);
+            }
         }
         if (constraint_table.cat_goals[location] < MAX_TIMESTEP)
             insertSoftConstraint2SIT(location, constraint_table.cat_goals[location], MAX_TIMESTEP + 1);
     }
 }
 
+bool ReservationTable::canShareSIT() const
+{
+    return constraint_table.length_max >= MAX_TIMESTEP - 1 and constraint_table.landmarks.empty() and
+           (constraint_table.path_table_for_CAT == nullptr or constraint_table.path_table_for_CAT->empty()) and
+           constraint_table.cat.empty();
+}
+
+// return the safe intervals cached by path_table_for_CT if they are the same as the ones that updateSIT would build,
+// i.e., the location is not the goal location and has no negative constraints; otherwise return nullptr
+const vector<Interval>* ReservationTable::getSharedSIT(int location) const
+{
+    if (!use_shared_sit or location == goal_location or location >= (int)constraint_table.map_size or
+        constraint_table.path_table_for_CT == nullptr)
+        return nullptr;
+    auto range = constraint_table.getConstraints(location);
+    if (range.first != range.second)
+        return nullptr;
+    return constraint_table.path_table_for_CT->getSafeIntervals(location);
+}
+
 // return <upper_bound, low, high,  vertex collision, edge collision>
 list<tuple<int, int, int, bool, bool>> ReservationTable::get_safe_intervals(int from, int to, int lower_bound, int upper_bound)
 {
-    list<tuple<int, int, int, bool, bool>> rst;
     if (lower_bound >= upper_bound)
-        return rst;
-
+        return list<tuple<int, int, int, bool, bool>>();
+    const auto* shared_sit = getSharedSIT(to);
+    if (shared_sit != nullptr)
+        return get_safe_intervals(from, to, lower_bound, upper_bound, *shared_sit);
     if (sit[to].empty())
         updateSIT(to);
+    return get_safe_intervals(from, to, lower_bound, upper_bound, sit[to]);
+}
 
-    for(auto interval : sit[to])
+template<class Intervals>
+list<tuple<int, int, int, bool, bool>> ReservationTable::get_safe_intervals(int from, int to, int lower_bound, int upper_bound,
+                                                                            const Intervals& safe_intervals) const
+{
+    list<tuple<int, int, int, bool, bool>> rst;
+    for(auto interval : safe_intervals)
     {
         if (lower_bound >= get<1>(interval))
             continue;
@@ -353,19 +368,18 @@ list<tuple<int, int, int, bool, bool>> ReservationTable::get_safe_intervals(int
 
 Interval ReservationTable::get_first_safe_interval(size_t location)
 {
+    const auto* shared_sit = getSharedSIT((int)location);
+    if (shared_sit != nullptr)
+        return shared_sit->front();
     if (sit[location].empty())
 	    updateSIT(location);
     return sit[location].front();
 }
 
-// find a safe interval with t_min as given
-bool ReservationTable::find_safe_interval(Interval& interval, size_t location, int t_min)
+template<class Intervals>
+static bool find_safe_interval(Interval& interval, const Intervals& safe_intervals, int t_min)
 {
-	if (t_min >= min(constraint_table.length_max, MAX_TIMESTEP - 1) + 1)
-		return false;
-    if (sit[location].empty())
-	    updateSIT(location);
-    for( auto & i : sit[location])
+    for( auto & i : safe_intervals)
     {
         if ((int)get<0>(i) <= t_min && t_min < (int)get<1>(i))
         {
@@ -378,6 +392,19 @@ bool ReservationTable::find_safe_interval(Interval& interval, size_t location, i
     return false;
 }
 
+// find a safe interval with t_min as given
+bool ReservationTable::find_safe_interval(Interval& interval, size_t location, int t_min)
+{
+	if (t_min >= min(constraint_table.length_max, MAX_TIMESTEP - 1) + 1)
+		return false;
+    const auto* shared_sit = getSharedSIT((int)location);
+    if (shared_sit != nullptr)
+        return ::find_safe_interval(interval, *shared_sit, t_min);
+    if (sit[location].empty())
+	    updateSIT(location);
+    return ::find_safe_interval(interval, sit[location], t_min);
+}
+
 int ReservationTable::get_earliest_arrival_time(int from, int to, int lower_bound, int upper_bound) const
 {
     for (auto t = lower_bound; t < upper_bound; t++)
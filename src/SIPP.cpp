@@ -1,5 +1,10 @@
 #include "SIPP.h"
 
+thread_local NodePool<SIPPNode> SIPP::node_pool;
+thread_local SIPP::hashtable_t SIPP::allNodes_table;
+thread_local SIPP::open_list_t SIPP::open_list;
+thread_local SIPP::focal_list_t SIPP::focal_list;
+
 void SIPP::updatePath(const LLNode* goal, vector<PathEntry> &path)
 {
     num_collisions = goal->num_of_conflicts;
@@ -25,23 +30,28 @@ void SIPP::updatePath(const LLNode* goal, vector<PathEntry> &path)
 
 
 // find path by A*
-// Returns a path that minimizes the collisions with the paths in the path table, breaking ties by the length
-Path SIPP::findPath(const ConstraintTable& constraint_table)
+// Writes into path a path that minimizes the collisions with the paths in the path table, breaking ties by the length
+void SIPP::findPath(const ConstraintTable& constraint_table, Path& path, int upper_bound)
 {
     reset();
+    prepareLists();
     //Path path = findNoCollisionPath(constraint_table);
     //if (!path.empty())
     //    return path;
     ReservationTable reservation_table(constraint_table, goal_location);
-    Path path;
+    path.clear();
+    if (my_heuristic[start_location] >= MAX_TIMESTEP) // the goal is unreachable
+        return;
     Interval interval = reservation_table.get_first_safe_interval(start_location);
     if (get<0>(interval) > 0)
-        return path;
+        return;
     auto holding_time = constraint_table.getHoldingTime(goal_location, constraint_table.length_min);
     auto last_target_collision_time = constraint_table.getLastCollisionTimestep(goal_location);
     // generate start and add it to the OPEN & FOCAL list
     auto h = max(max(my_heuristic[start_location], holding_time), last_target_collision_time + 1);
-    auto start = new SIPPNode(start_location, 0, h, nullptr, 0, get<1>(interval), get<1>(interval),
+    if (h > upper_bound)
+        return;
+    auto start = node_pool.create(start_location, 0, h, nullptr, 0, get<1>(interval), get<1>(interval),
                                 get<2>(interval), get<2>(interval));
     pushNodeToFocal(start);
 
@@ -69,7 +79,7 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
                 break;
             }
             // generate a goal node
-            auto goal = new SIPPNode(*curr);
+            auto goal = node_pool.create(*curr);
             goal->is_goal = true;
             goal->h_val = 0;
             goal->num_of_conflicts += future_collisions;
@@ -77,7 +87,7 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
             if (dominanceCheck(goal))
                 pushNodeToFocal(goal);
             else
-                delete goal;
+                node_pool.release(goal);
         }
 
         for (int next_location : instance.getNeighbors(curr->location)) // move to neighboring locations
@@ -95,14 +105,16 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
                                       (int)next_v_collision + (int)next_e_collision;
                 auto next_h_val = max(my_heuristic[next_location], (next_collisions > 0?
                     holding_time : curr->getFVal()) - next_timestep); // path max
+                if (next_timestep + next_h_val > upper_bound) // and so are the later intervals
+                    break;
                 // generate (maybe temporary) node
-                auto next = new SIPPNode(next_location, next_timestep, next_h_val, curr, next_timestep,
+                auto next = node_pool.create(next_location, next_timestep, next_h_val, curr, next_timestep,
                                          next_high_generation, next_high_expansion, next_v_collision, next_collisions);
                 // try to retrieve it from the hash table
                 if (dominanceCheck(next))
                     pushNodeToFocal(next);
                 else
-                    delete next;
+                    node_pool.release(next);
             }
         }  // end for loop that generates successors
         // wait at the current location
@@ -112,17 +124,20 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
         {
             auto next_timestep = get<0>(interval);
             auto next_h_val = max(my_heuristic[curr->location], (get<2>(interval) ? holding_time : curr->getFVal()) - next_timestep); // path max
-            auto next_collisions = curr->num_of_conflicts +
-                    // (int)curr->collision_v * max(next_timestep - curr->timestep - 1, 0) +
-		    (int)get<2>(interval);
-            auto next = new SIPPNode(curr->location, next_timestep, next_h_val, curr, next_timestep,
-                                     get<1>(interval), get<1>(interval), get<2>(interval),
-                                     next_collisions);
-            next->wait_at_goal = (curr->location == goal_location);
-            if (dominanceCheck(next))
-                pushNodeToFocal(next);
-            else
-                delete next;
+            if (next_timestep + next_h_val <= upper_bound)
+            {
+                auto next_collisions = curr->num_of_conflicts +
+                        // (int)curr->collision_v * max(next_timestep - curr->timestep - 1, 0) +
+                        (int)get<2>(interval);
+                auto next = node_pool.create(curr->location, next_timestep, next_h_val, curr, next_timestep,
+                                         get<1>(interval), get<1>(interval), get<2>(interval),
+                                         next_collisions);
+                next->wait_at_goal = (curr->location == goal_location);
+                if (dominanceCheck(next))
+                    pushNodeToFocal(next);
+                else
+                    node_pool.release(next);
+            }
         }
     }  // end while loop
 
@@ -131,7 +146,6 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
     //    printSearchTree();
     //}
     releaseNodes();
-    return path;
 }
 Path SIPP::findOptimalPath(const HLNode& node, const ConstraintTable& initial_constraints,
 	const vector<Path*>& paths, int agent, int lowerbound)
@@ -146,6 +160,7 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 	const vector<Path*>& paths, int agent, int lowerbound, double w)
 {
     reset();
+    prepareLists();
 	this->w = w;
 
 	// build constraint table
@@ -155,7 +170,8 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 	runtime_build_CT = (double)(clock() - t) / CLOCKS_PER_SEC;
 	int holding_time = constraint_table.getHoldingTime(goal_location, constraint_table.length_min);
 	t = clock();
-    constraint_table.insert2CAT(agent, paths);
+	if (constraint_table.path_table_for_CAT == nullptr) // otherwise, the paths are already in path_table_for_CAT
+		constraint_table.insert2CAT(agent, paths);
 	runtime_build_CAT = (double)(clock() - t) / CLOCKS_PER_SEC;
 
 	// build reservation table
@@ -169,7 +185,7 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 		return {path, 0};
 
 	 // generate start and add it to the OPEN list
-	auto start = new SIPPNode(start_location, 0, max(my_heuristic[start_location], holding_time), nullptr, 0,
+	auto start = node_pool.create(start_location, 0, max(my_heuristic[start_location], holding_time), nullptr, 0,
         get<1>(interval), get<1>(interval), get<2>(interval), get<2>(interval));
     min_f_val = max(holding_time, max((int)start->getFVal(), lowerbound));
     pushNodeToOpenAndFocal(start);
@@ -178,7 +194,7 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 	{
 		updateFocalList(); // update FOCAL if min f-val increased
 		SIPPNode* curr = focal_list.top(); focal_list.pop();
-		open_list.erase(curr->open_handle);
+		open_list.erase(curr);
 		curr->in_openlist = false;
 		num_expanded++;
 
@@ -207,12 +223,12 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
                 int next_conflicts = curr->num_of_conflicts +
                         //(int)curr->collision_v * max(next_timestep - curr->timestep - 1, 0) +
                         (int)next_v_collision + (int)next_e_collision;
-                auto next = new SIPPNode(next_location, next_g_val, next_h_val, curr, next_timestep,
+                auto next = node_pool.create(next_location, next_g_val, next_h_val, curr, next_timestep,
                         next_high_generation, next_high_expansion, next_v_collision, next_conflicts);
                 if (dominanceCheck(next))
                     pushNodeToOpenAndFocal(next);
                 else
-                    delete next;
+                    node_pool.release(next);
 			}
 		}  // end for loop that generates successors
 		   
@@ -226,14 +242,14 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
             auto next_collisions = curr->num_of_conflicts +
                                    //(int)curr->collision_v * max(next_timestep - curr->timestep - 1, 0) + // wait time
                                    (int)get<2>(interval);
-            auto next = new SIPPNode(curr->location, next_timestep, next_h_val, curr, next_timestep,
+            auto next = node_pool.create(curr->location, next_timestep, next_h_val, curr, next_timestep,
                                      get<1>(interval), get<1>(interval), get<2>(interval), next_collisions);
             if (curr->location == goal_location)
                 next->wait_at_goal = true;
             if (dominanceCheck(next))
                 pushNodeToOpenAndFocal(next);
             else
-                delete next;
+                node_pool.release(next);
 		}
 	}  // end while loop
 	  
@@ -244,6 +260,7 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 /*Path SIPP::findNoCollisionPath(const ConstraintTable& constraint_table)
 {
     reset();
+    prepareLists();
     ReservationTable reservation_table(constraint_table, goal_location);
     Path path;
     Interval interval = reservation_table.get_first_safe_interval(start_location);
@@ -253,7 +270,7 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
                             constraint_table.getLastCollisionTimestep(goal_location) + 1);
     // generate start and add it to the OPEN & FOCAL list
 
-    auto start = new SIPPNode(start_location, 0, max(my_heuristic[start_location], holding_time),
+    auto start = node_pool.create(start_location, 0, max(my_heuristic[start_location], holding_time),
                               nullptr, 0, interval, 0);
     pushNodeToFocal(start);
     while (!focal_list.empty())
@@ -302,9 +319,10 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 int SIPP::getTravelTime(int start, int end, const ConstraintTable& constraint_table, int upper_bound)
 {
     reset();
+    prepareLists();
     min_f_val = -1; // this disables focal list
     int length = MAX_TIMESTEP;
-    auto root = new SIPPNode(start, 0, compute_heuristic(start, end), nullptr, 0, 1, 1, 0, 0);
+    auto root = node_pool.create(start, 0, compute_heuristic(start, end), nullptr, 0, 1, 1, 0, 0);
     pushNodeToOpenAndFocal(root);
     auto static_timestep = constraint_table.getMaxTimestep(); // everything is static after this timestep
     while (!open_list.empty())
@@ -315,9 +333,7 @@ int SIPP::getTravelTime(int start, int end, const ConstraintTable& constraint_ta
             length = curr->g_val;
             break;
         }
-        list<int> next_locations = instance.getNeighbors(curr->location);
-        next_locations.emplace_back(curr->location);
-        for (int next_location : next_locations)
+        for (int next_location : instance.getNextLocations(curr->location))
         {
             int next_timestep = curr->timestep + 1;
             int next_g_val = curr->g_val + 1;
@@ -335,12 +351,12 @@ int SIPP::getTravelTime(int start, int end, const ConstraintTable& constraint_ta
                 int next_h_val = compute_heuristic(next_location, end);
                 if (next_g_val + next_h_val >= upper_bound) // the cost of the path is larger than the upper bound
                     continue;
-                auto next = new SIPPNode(next_location, next_g_val, next_h_val, nullptr, next_timestep,
+                auto next = node_pool.create(next_location, next_g_val, next_h_val, nullptr, next_timestep,
                                          next_timestep + 1, next_timestep + 1, 0, 0);
                 if (dominanceCheck(next))
                     pushNodeToOpenAndFocal(next);
                 else
-                    delete next;
+                    node_pool.release(next);
             }
         }
     }
@@ -357,11 +373,9 @@ void SIPP::updateFocalList()
 	if (open_head->getFVal() > min_f_val)
 	{
 		int new_min_f_val = (int)open_head->getFVal();
-		for (auto n : open_list)
-		{
-			if (n->getFVal() > w * min_f_val && n->getFVal() <= w * new_min_f_val)
-				n->focal_handle = focal_list.push(n);
-		}
+		// push the nodes with f-vals in (w * min_f_val, w * new_min_f_val] to FOCAL
+		open_list.forEach((int)(w * min_f_val) + 1, (int)(w * new_min_f_val),
+		                  [this](SIPPNode* n) { focal_list.push(n); });
 		min_f_val = new_min_f_val;
 	}
 }
@@ -369,61 +383,66 @@ void SIPP::updateFocalList()
 inline void SIPP::pushNodeToOpenAndFocal(SIPPNode* node)
 {
     num_generated++;
-	node->open_handle = open_list.push(node);
+	open_list.push(node);
 	node->in_openlist = true;
 	if (node->getFVal() <= w * min_f_val)
-		node->focal_handle = focal_list.push(node);
-    allNodes_table[node].push_back(node);
+		focal_list.push(node);
+    insertNodeToTable(node);
 }
 inline void SIPP::pushNodeToFocal(SIPPNode* node)
 {
     num_generated++;
-    allNodes_table[node].push_back(node);
+    insertNodeToTable(node);
     node->in_openlist = true;
-    node->focal_handle = focal_list.push(node); // we only use focal list; no open list is used
+    focal_list.push(node); // we only use focal list; no open list is used
 }
 inline void SIPP::eraseNodeFromLists(SIPPNode* node)
 {
     if (open_list.empty())
     { // we only have focal list
-        focal_list.erase(node->focal_handle);
+        focal_list.erase(node);
     }
     else if (focal_list.empty())
     {  // we only have open list
-        open_list.erase(node->open_handle);
+        open_list.erase(node);
     }
     else
     { // we have both open and focal
-        open_list.erase(node->open_handle);
+        open_list.erase(node);
         if (node->getFVal() <= w * min_f_val)
-            focal_list.erase(node->focal_handle);
+            focal_list.erase(node);
     }
 }
+inline void SIPP::insertNodeToTable(SIPPNode* node) // append the node to the list of its duplicates
+{
+    node->next_duplicate = nullptr;
+    auto* link = &allNodes_table[node];
+    while (*link != nullptr)
+        link = &(*link)->next_duplicate;
+    *link = node;
+}
 void SIPP::releaseNodes()
 {
     open_list.clear();
     focal_list.clear();
-    for (auto & node_list : allNodes_table)
-        for (auto n : node_list.second)
-            delete n;
     allNodes_table.clear();
-    for (auto n : useless_nodes)
-        delete n;
-    useless_nodes.clear();
+    peak_num_of_nodes = node_pool.getPeakNumOfNodes();
+    max_num_of_nodes = max(max_num_of_nodes, peak_num_of_nodes);
+    node_pool.clear();
 }
 
 void SIPP::printSearchTree() const
 {
     vector<list<SIPPNode*>> nodes;
-    for (const auto & node_list : allNodes_table)
+    allNodes_table.forEach([&nodes](SIPPNode* first)
     {
-        for (const auto & n : node_list.second)
+        for (auto n = first; n != nullptr; n = n->next_duplicate)
         {
             if (nodes.size() <= n->timestep)
                 nodes.resize(n->timestep + 1);
             nodes[n->timestep].emplace_back(n);
         }
-    }
+    });
     cout << "Search Tree" << endl;
     for(int t = 0; t < nodes.size(); t++)
     {
@@ -438,10 +457,11 @@ void SIPP::printSearchTree() const
 bool SIPP::dominanceCheck(SIPPNode* new_node)
 {
     auto ptr = allNodes_table.find(new_node);
-    if (ptr == allNodes_table.end())
+    if (ptr == nullptr)
         return true;
-    for (auto & old_node : ptr->second)
+    for (auto link = ptr; *link != nullptr; link = &(*link)->next_duplicate)
     {
+        auto old_node = *link;
         if (old_node->timestep <= new_node->timestep and
             old_node->num_of_conflicts <= new_node->num_of_conflicts)
         { // the new node is dominated by the old node
@@ -454,8 +474,8 @@ bool SIPP::dominanceCheck(SIPPNode* new_node)
                 eraseNodeFromLists(old_node); // delete it from open and/or focal lists
             else // the old node has been expanded already
                 num_reopened++; //re-expand it
-            useless_nodes.push_back(old_node);
-            ptr->second.remove(old_node);
+            // keep the old node in the pool because it can be the parent of other nodes
+            *link = old_node->next_duplicate; // remove it from the list of duplicates
             num_generated--; // this is because we later will increase num_generated when we insert the new node into lists.
             return true;
         }
@@ -1,5 +1,10 @@
 #include "SpaceTimeAStar.h"
 
+thread_local NodePool<AStarNode> SpaceTimeAStar::node_pool;
+thread_local SpaceTimeAStar::hashtable_t SpaceTimeAStar::allNodes_table;
+thread_local SpaceTimeAStar::open_list_t SpaceTimeAStar::open_list;
+thread_local SpaceTimeAStar::focal_list_t SpaceTimeAStar::focal_list;
+
 
 void SpaceTimeAStar::updatePath(const LLNode* goal, vector<PathEntry> &path)
 {
@@ -24,24 +29,29 @@ Path SpaceTimeAStar::findOptimalPath(const HLNode& node, const ConstraintTable&
 }
 
 // find path by time-space A* search
-// Returns a path that minimizes the collisions with the paths in the path table, breaking ties by the length
-Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
+// Writes into path a path that minimizes the collisions with the paths in the path table, breaking ties by the length
+void SpaceTimeAStar::findPath(const ConstraintTable& constraint_table, Path& path, int upper_bound)
 {
     reset();
-    Path path;
+    prepareLists();
+    path.clear();
+    if (my_heuristic[start_location] >= MAX_TIMESTEP) // the goal is unreachable
+        return;
     if (constraint_table.constrained(start_location, 0))
     {
-        return path;
+        return;
     }
     auto holding_time = constraint_table.getHoldingTime(goal_location, constraint_table.length_min); // the earliest timestep that the agent can hold its goal location. The length_min is considered here.
     auto static_timestep = constraint_table.getMaxTimestep() + 1; // everything is static after this timestep
     auto last_target_collision_time = constraint_table.getLastCollisionTimestep(goal_location);
     // generate start and add it to the OPEN & FOCAL list
     auto h = max(max(my_heuristic[start_location], holding_time), last_target_collision_time + 1);
-    auto start = new AStarNode(start_location, 0, h, nullptr, 0, 0);
+    if (h > upper_bound)
+        return;
+    auto start = node_pool.create(start_location, 0, h, nullptr, 0, 0);
     num_generated++;
     start->in_openlist = true;
-    start->focal_handle = focal_list.push(start); // we only use focal list; no open list is used
+    focal_list.push(start); // we only use focal list; no open list is used
     allNodes_table.insert(start);
     while (!focal_list.empty())
     {
@@ -67,16 +77,16 @@ Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
                 break;
             }
             // generate a goal node
-            auto goal = new AStarNode(*curr);
+            auto goal = node_pool.create(*curr);
             goal->is_goal = true;
             goal->parent = curr;
             goal->num_of_conflicts += future_collisions;
             goal->h_val = 0;
             // try to retrieve it from the hash table
             auto it = allNodes_table.find(goal);
-            if (it == allNodes_table.end())
+            if (it == nullptr)
             {
-                goal->focal_handle = focal_list.push(goal);
+                focal_list.push(goal);
                 goal->in_openlist = true;
                 num_generated++;
                 allNodes_table.insert(goal);
@@ -90,18 +100,16 @@ Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
                 {
                     assert(existing_next->in_openlist);
                     existing_next->copy(*goal);	// update existing node
-                    focal_list.update(existing_next->focal_handle);
+                    focal_list.update(existing_next);
                     num_generated++; // reopen is considered as a new node
                 }
-                delete (goal);
+                node_pool.release(goal);
             }
         }
         if (curr->timestep >= constraint_table.length_max)
             continue;
 
-        auto next_locations = instance.getNeighbors(curr->location);
-        next_locations.emplace_back(curr->location);
-        for (int next_location : next_locations)
+        for (int next_location : instance.getNextLocations(curr->location))
         {
             int next_timestep = curr->timestep + 1;
             if (static_timestep < next_timestep)
@@ -128,8 +136,10 @@ Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
                 next_h_val = max(next_h_val, curr->getFVal() - next_g_val);  // path max
             else
                 next_h_val = max(next_h_val, holding_time - next_g_val); // path max
+            if (next_g_val + next_h_val > upper_bound)
+                continue;
             // generate (maybe temporary) node
-            auto next = new AStarNode(next_location, next_g_val, next_h_val,
+            auto next = node_pool.create(next_location, next_g_val, next_h_val,
                                       curr, next_timestep, num_conflicts);
 
             if (next_location == goal_location && curr->location == goal_location)
@@ -137,9 +147,9 @@ Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
 
             // try to retrieve it from the hash table
             auto it = allNodes_table.find(next);
-            if (it == allNodes_table.end())
+            if (it == nullptr)
             {
-                next->focal_handle = focal_list.push(next);
+                focal_list.push(next);
                 next->in_openlist = true;
                 num_generated++;
                 allNodes_table.insert(next);
@@ -155,23 +165,22 @@ Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
                 if (!existing_next->in_openlist) // if its in the closed list (reopen)
                 {
                     existing_next->copy(*next);
-                    existing_next->focal_handle = focal_list.push(existing_next);
+                    focal_list.push(existing_next);
                     existing_next->in_openlist = true;
                     num_generated++; // reopen is considered as a new node
                 }
                 else
                 {
                     existing_next->copy(*next);	// update existing node
-                    focal_list.update(existing_next->focal_handle);
+                    focal_list.update(existing_next);
                 }
             }
 
-            delete(next);  // not needed anymore -- we already generated it before
+            node_pool.release(next);  // not needed anymore -- we already generated it before
         }  // end for loop that generates successors
     }  // end while loop
 
     releaseNodes();
-    return path;
 }
 
 // find path by time-space A* search
@@ -182,6 +191,7 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 	const vector<Path*>& paths, int agent, int lowerbound, double w)
 {
     reset();
+    prepareLists();
 	this->w = w;
 	Path path;
 
@@ -196,7 +206,8 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 	}
 
 	t = clock();
-    constraint_table.insert2CAT(agent, paths);
+	if (constraint_table.path_table_for_CAT == nullptr) // otherwise, the paths are already in path_table_for_CAT
+		constraint_table.insert2CAT(agent, paths);
 	runtime_build_CAT = (double)(clock() - t) / CLOCKS_PER_SEC;
 
 	// the earliest timestep that the agent can hold its goal location. The length_min is considered here.
@@ -205,11 +216,11 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
     lowerbound =  max(holding_time, lowerbound);
 
 	// generate start and add it to the OPEN & FOCAL list
-	auto start = new AStarNode(start_location, 0, max(lowerbound, my_heuristic[start_location]), nullptr, 0, 0);
+	auto start = node_pool.create(start_location, 0, max(lowerbound, my_heuristic[start_location]), nullptr, 0, 0);
 
 	num_generated++;
-	start->open_handle = open_list.push(start);
-	start->focal_handle = focal_list.push(start);
+	open_list.push(start);
+	focal_list.push(start);
 	start->in_openlist = true;
 	allNodes_table.insert(start);
 	min_f_val = (int) start->getFVal();
@@ -232,9 +243,7 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 		if (curr->timestep >= constraint_table.length_max)
 			continue;
 
-		auto next_locations = instance.getNeighbors(curr->location);
-		next_locations.emplace_back(curr->location);
-		for (int next_location : next_locations)
+		for (int next_location : instance.getNextLocations(curr->location))
 		{
 			int next_timestep = curr->timestep + 1;
 			if (static_timestep < next_timestep)
@@ -259,14 +268,14 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 				constraint_table.getNumOfConflictsForStep(curr->location, next_location, next_timestep);
 
 			// generate (maybe temporary) node
-			auto next = new AStarNode(next_location, next_g_val, next_h_val,
+			auto next = node_pool.create(next_location, next_g_val, next_h_val,
 				curr, next_timestep, next_internal_conflicts);
 			if (next_location == goal_location && curr->location == goal_location)
 				next->wait_at_goal = true;
 
 			// try to retrieve it from the hash table
 			auto it = allNodes_table.find(next);
-			if (it == allNodes_table.end())
+			if (it == nullptr)
 			{
 				pushNode(next);
 				allNodes_table.insert(next);
@@ -302,15 +311,15 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 					existing_next->copy(*next);	// update existing node
 
 					if (update_open)
-						open_list.increase(existing_next->open_handle);  // increase because f-val improved
+						open_list.update(existing_next);  // increase because f-val improved
 					if (add_to_focal)
-						existing_next->focal_handle = focal_list.push(existing_next);
+						focal_list.push(existing_next);
 					if (update_in_focal)
-						focal_list.update(existing_next->focal_handle);  // should we do update? yes, because number of conflicts may go up or down			
+						focal_list.update(existing_next);  // should we do update? yes, because number of conflicts may go up or down			
 				}
 			}
 
-			delete(next);  // not needed anymore -- we already generated it before
+			node_pool.release(next);  // not needed anymore -- we already generated it before
 		}  // end for loop that generates successors
 	}  // end while loop
 
@@ -322,10 +331,11 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 int SpaceTimeAStar::getTravelTime(int start, int end, const ConstraintTable& constraint_table, int upper_bound)
 {
     reset();
+    prepareLists();
 	int length = MAX_TIMESTEP;
     auto static_timestep = constraint_table.getMaxTimestep() + 1; // everything is static after this timestep
-	auto root = new AStarNode(start, 0, compute_heuristic(start, end), nullptr, 0, 0);
-	root->open_handle = open_list.push(root);  // add root to heap
+	auto root = node_pool.create(start, 0, compute_heuristic(start, end), nullptr, 0, 0);
+	open_list.push(root);  // add root to heap
 	allNodes_table.insert(root);       // add root to hash_table (nodes)
 	AStarNode* curr = nullptr;
 	while (!open_list.empty())
@@ -336,9 +346,7 @@ int SpaceTimeAStar::getTravelTime(int start, int end, const ConstraintTable& con
 			length = curr->g_val;
 			break;
 		}
-		list<int> next_locations = instance.getNeighbors(curr->location);
-		next_locations.emplace_back(curr->location);
-		for (int next_location : next_locations)
+		for (int next_location : instance.getNextLocations(curr->location))
 		{
 			int next_timestep = curr->timestep + 1;
 			int next_g_val = curr->g_val + 1;
@@ -356,21 +364,21 @@ int SpaceTimeAStar::getTravelTime(int start, int end, const ConstraintTable& con
 				int next_h_val = compute_heuristic(next_location, end);
 				if (next_g_val + next_h_val >= upper_bound) // the cost of the path is larger than the upper bound
 					continue;
-				auto next = new AStarNode(next_location, next_g_val, next_h_val, nullptr, next_timestep, 0);
+				auto next = node_pool.create(next_location, next_g_val, next_h_val, nullptr, next_timestep, 0);
 				auto it = allNodes_table.find(next);
-				if (it == allNodes_table.end())
+				if (it == nullptr)
 				{  // add the newly generated node to heap and hash table
-					next->open_handle = open_list.push(next);
+					open_list.push(next);
 					allNodes_table.insert(next);
 				}
 				else {  // update existing node's g_val if needed (only in the heap)
-					delete(next);  // not needed anymore -- we already generated it before
+					node_pool.release(next);  // not needed anymore -- we already generated it before
 					auto existing_next = *it;
 					if (existing_next->g_val > next_g_val)
 					{
 						existing_next->g_val = next_g_val;
 						existing_next->timestep = next_timestep;
-						open_list.increase(existing_next->open_handle);
+						open_list.update(existing_next);
 					}
 				}
 			}
@@ -386,7 +394,7 @@ int SpaceTimeAStar::getTravelTime(int start, int end, const ConstraintTable& con
 inline AStarNode* SpaceTimeAStar::popNode()
 {
 	auto node = focal_list.top(); focal_list.pop();
-	open_list.erase(node->open_handle);
+	open_list.erase(node);
 	node->in_openlist = false;
 	num_expanded++;
 	return node;
@@ -395,11 +403,11 @@ inline AStarNode* SpaceTimeAStar::popNode()
 
 inline void SpaceTimeAStar::pushNode(AStarNode* node)
 {
-	node->open_handle = open_list.push(node);
+	open_list.push(node);
 	node->in_openlist = true;
 	num_generated++;
 	if (node->getFVal() <= w * min_f_val)
-		node->focal_handle = focal_list.push(node);		
+		focal_list.push(node);		
 }
 
 
@@ -409,11 +417,9 @@ void SpaceTimeAStar::updateFocalList()
 	if (open_head->getFVal() > min_f_val)
 	{
 		int new_min_f_val = (int)open_head->getFVal();
-		for (auto n : open_list)
-		{
-			if (n->getFVal() >  w * min_f_val && n->getFVal() <= w * new_min_f_val)
-				n->focal_handle = focal_list.push(n);
-		}
+		// push the nodes with f-vals in (w * min_f_val, w * new_min_f_val] to FOCAL
+		open_list.forEach((int)(w * min_f_val) + 1, (int)(w * new_min_f_val),
+		                  [this](AStarNode* n) { focal_list.push(n); });
 		min_f_val = new_min_f_val;
 	}
 }
@@ -423,8 +429,9 @@ void SpaceTimeAStar::releaseNodes()
 {
 	open_list.clear();
 	focal_list.clear();
-	for (auto node: allNodes_table)
-		delete node;
 	allNodes_table.clear();
+	peak_num_of_nodes = node_pool.getPeakNumOfNodes();
+	max_num_of_nodes = max(max_num_of_nodes, peak_num_of_nodes);
+	node_pool.clear();
 }
 
@@ -30,14 +30,22 @@ int main(int argc, char** argv)
 		("solver", po::value<string>()->default_value("LNS"), "solver (LNS, A-BCBS, A-EECBS)")
 		("sipp", po::value<bool>()->default_value(true), "Use SIPP as the single-agent solver")
 		("seed", po::value<int>()->default_value(0), "Random seed")
+		("heuristicCache", po::value<string>(),
+		        "directory where the distances to goal locations are cached for later runs on the same map")
 
         // params for LNS
         ("initLNS", po::value<bool>()->default_value(true),
              "use LNS to find initial solutions if the initial sovler fails")
         ("neighborSize", po::value<int>()->default_value(8), "Size of the neighborhood")
+        ("adaptiveNeighborSize", po::value<bool>()->default_value(false),
+             "experimental: let adaptive LNS choose the neighbor size (2, 4, ..., 32) together with the destroy heuristic; "
+             "it has not been measured to beat a fixed neighbor size")
+        ("adaptiveReplanTime", po::value<bool>()->default_value(false),
+             "learn the time limit of every repair from the runtimes of the recent repairs of the same neighbor size "
+             "(otherwise, it is 1% of the time limit)")
         ("maxIterations", po::value<int>()->default_value(0), "maximum number of iterations")
         ("initAlgo", po::value<string>()->default_value("PP"),
-                "MAPF algorithm for finding the initial solution (EECBS, PP, PPS, CBS, PIBT, winPIBT)")
+                "MAPF algorithm for finding the initial solution (EECBS, PP, PPS, CBS, PIBT, winPIBT, Portfolio)")
         ("replanAlgo", po::value<string>()->default_value("PP"),
                 "MAPF algorithm for replanning (EECBS, CBS, PP)")
         ("destoryStrategy", po::value<string>()->default_value("Adaptive"),
@@ -46,6 +54,8 @@ int main(int argc, char** argv)
              "window size for winPIBT")
         ("winPibtSoftmode", po::value<bool>()->default_value(true),
              "winPIBT soft mode")
+        ("threads", po::value<int>()->default_value(1),
+             "number of threads that replan neighbors in parallel, in both LNS and InitLNS (only for replanAlgo=PP)")
 
          // params for initLNS
          ("initDestoryStrategy", po::value<string>()->default_value("Adaptive"),
@@ -69,9 +79,12 @@ int main(int argc, char** argv)
 
 	Instance instance(vm["map"].as<string>(), vm["agents"].as<string>(),
 		vm["agentNum"].as<int>());
+	if (vm.count("heuristicCache"))
+		instance.setDistanceCache(vm["heuristicCache"].as<string>());
     double time_limit = vm["cutoffTime"].as<double>();
     int screen = vm["screen"].as<int>();
 	srand(vm["seed"].as<int>());
+	instance.setRandomSeed(vm["seed"].as<int>());
 
 	if (vm["solver"].as<string>() == "LNS")
     {
@@ -84,7 +97,10 @@ int main(int argc, char** argv)
                 vm["initLNS"].as<bool>(),
                 vm["initDestoryStrategy"].as<string>(),
                 vm["sipp"].as<bool>(),
-                screen, pipp_option);
+                screen, pipp_option,
+                vm["threads"].as<int>(),
+                vm["adaptiveNeighborSize"].as<bool>(),
+                vm["adaptiveReplanTime"].as<bool>());
         bool succ = lns.run();
         if (succ)
         {